@@ -136,7 +136,7 @@ static void Usage()
 	Info() << "";
 	Info() << "\tModel specific settings:";
 	Info() << "";
-	Info() << "\t[-go Model: AFC_WIDE [on/off] FP_DS [on/off] PS_EMA [on/off] SOXR [on/off] SRC [on/off] DROOP [on/off] ]";
+	Info() << "\t[-go Model: AFC_WIDE [on/off] FP_DS [on/off] PS_EMA [on/off] SOXR [on/off] SRC [on/off] POLYPHASE [on/off] DROOP [on/off] THREADED [on/off] ]";
 }
 
 static void printDevices(Receiver &r, bool JSON = false)
@@ -933,6 +933,10 @@ int main(int argc, char *argv[])
 					stat[i].statistics[j].Stamp();
 					ss << "[" << name << "] " << std::string(37 - name.length(), ' ') << "total: " << stat[i].statistics[j].getCount() << " msgs" << "\n";
 				}
+
+				std::string buffer = r.device ? r.device->getBufferStatus() : "";
+				if (!buffer.empty())
+					ss << "[" << r.device->getProduct() << " buffer] " << buffer << "\n";
 			}
 
 			if (r.Timing())
@@ -109,6 +109,14 @@ std::string PromotheusCounter::toPrometheus() {
 	element += "# TYPE ais_stat_distance gauge\n";
 	element += "ais_stat_distance " + std::to_string(_distance) + "\n";
 
+	element += "# HELP ais_stat_dedup_unique Total number of frames passed by the decoder dedup stage\n";
+	element += "# TYPE ais_stat_dedup_unique counter\n";
+	element += "ais_stat_dedup_unique " + std::to_string(AIS::DecoderDedup::getUnique()) + "\n";
+
+	element += "# HELP ais_stat_dedup_dropped Total number of duplicate frames dropped by the decoder dedup stage\n";
+	element += "# TYPE ais_stat_dedup_dropped counter\n";
+	element += "ais_stat_dedup_dropped " + std::to_string(AIS::DecoderDedup::getDropped()) + "\n";
+
 	for (int i = 0; i < 4; i++) {
 		std::string ch(1, i + 'A');
 		element += "# HELP ais_stat_count_channel_" + ch + " Total number of messages on channel " + ch + "\n";
@@ -384,6 +384,9 @@ void Receiver::stop()
 {
 	if (device)
 		device->Stop();
+
+	for (auto &m : models)
+		m->Stop();
 }
 
 //-----------------------------------
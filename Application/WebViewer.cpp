@@ -446,6 +446,43 @@ void WebViewer::close()
 	}
 }
 
+// delta requests for the ship list carry "since=<seq>", returns -1 if absent
+static int64_t getSince(const std::string &a)
+{
+	if (a.compare(0, 6, "since=") != 0)
+		return -1;
+
+	int64_t since = -1;
+	std::stringstream ss(a.substr(6));
+	if (!(ss >> since) || since < 0)
+		return -1;
+
+	return since;
+}
+
+// area requests carry a comma separated list of n numbers
+static bool getNumbers(const std::string &a, float *v, int n)
+{
+	std::stringstream ss(a);
+	std::string s;
+
+	for (int i = 0; i < n; i++)
+	{
+		if (!std::getline(ss, s, ','))
+			return false;
+
+		try
+		{
+			v[i] = std::stof(s);
+		}
+		catch (const std::exception &)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
 void WebViewer::Request(TCP::ServerConnection &c, const std::string &response, bool gzip)
 {
 
@@ -592,9 +629,33 @@ void WebViewer::Request(TCP::ServerConnection &c, const std::string &response, b
 	}
 	else if (r == "/api/ships_array.json")
 	{
-		std::string content = ships.getJSONcompact();
+		std::string content = ships.getJSONcompact(false, getSince(a));
 		Response(c, "application/json", content, use_zlib & gzip);
 	}
+	else if (r == "/api/ships_area.json")
+	{
+		// lat_min,lon_min,lat_max,lon_max, lon_min > lon_max crosses the antimeridian
+		float v[4];
+		if (getNumbers(a, v, 4) && v[0] >= -90 && v[2] <= 90 && v[0] <= v[2] && v[1] >= -180 && v[1] <= 180 && v[3] >= -180 && v[3] <= 180)
+		{
+			std::string content = ships.getJSONcompactArea(v[0], v[1], v[2], v[3]);
+			Response(c, "application/json", content, use_zlib & gzip);
+		}
+		else
+			Response(c, "application/json", "{\"error\":\"Invalid area\"}", use_zlib & gzip);
+	}
+	else if (r == "/api/ships_radius.json")
+	{
+		// lat,lon,radius in nmi
+		float v[3];
+		if (getNumbers(a, v, 3) && v[0] >= -90 && v[0] <= 90 && v[1] >= -180 && v[1] <= 180 && v[2] > 0)
+		{
+			std::string content = ships.getJSONcompactRadius(v[0], v[1], v[2]);
+			Response(c, "application/json", content, use_zlib & gzip);
+		}
+		else
+			Response(c, "application/json", "{\"error\":\"Invalid radius query\"}", use_zlib & gzip);
+	}
 	else if (r == "/api/planes_array.json")
 	{
 		std::string content = planes.getCompactArray();
@@ -603,7 +664,7 @@ void WebViewer::Request(TCP::ServerConnection &c, const std::string &response, b
 	else if (r == "/sb")
 	{
 		binary.clear();
-		ships.getBinary(binary);
+		ships.getBinary(binary, getSince(a));
 		Response(c, "application/octet-stream", binary.data(), binary.size(), use_zlib & gzip);
 	}
 	else if (r == "/api/ships_full.json")
@@ -0,0 +1,146 @@
+/*
+	Copyright(c) 2021-2025 jvde.github@gmail.com
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Counts heap allocations per message for decoding to JSON and per document for parsing JSON,
+// on recorded messages, built with -DBENCH=ON
+// usage: bench-allocations <NMEA file> [repetitions]
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "NMEA.h"
+#include "JSONAIS.h"
+#include "Keys.h"
+#include "JSON/Parser.h"
+#include "JSON/StringBuilder.h"
+
+static std::atomic<long> allocations(0);
+
+void* operator new(std::size_t sz) {
+	allocations++;
+	void* p = malloc(sz ? sz : 1);
+	if (!p) throw std::bad_alloc();
+	return p;
+}
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, std::size_t) noexcept { free(p); }
+
+// called by the library on fatal errors, normally provided by the application
+void StopRequest() {}
+
+class Messages : public StreamIn<AIS::Message> {
+public:
+	std::vector<AIS::Message> list;
+
+	void Receive(const AIS::Message* data, int len, TAG& tag) {
+		for (int i = 0; i < len; i++) list.push_back(data[i]);
+	}
+};
+
+// serializes every document into a reused string, as the JSON outputs do
+class Output : public StreamIn<JSON::JSON> {
+	JSON::StringBuilder builder;
+
+public:
+	std::string json;
+	std::vector<std::string>* keep = nullptr;
+
+	Output() : builder(&AIS::KeyMap, JSON_DICT_FULL) {}
+
+	void Receive(const JSON::JSON* data, int len, TAG& tag) {
+		json.clear();
+		builder.stringify(data[0], json);
+		if (keep) keep->push_back(json);
+	}
+};
+
+int main(int argc, char* argv[]) {
+	int repeat = argc > 2 ? atoi(argv[2]) : 10;
+	std::ifstream file(argc > 1 ? argv[1] : "");
+
+	if (!file || repeat <= 0) {
+		fprintf(stderr, "usage: %s <NMEA file> [repetitions]\n", argv[0]);
+		return 1;
+	}
+
+	std::stringstream ss;
+	ss << file.rdbuf();
+	std::string text = ss.str();
+
+	AIS::NMEA nmea;
+	Messages messages;
+	TAG tag;
+
+	// include the signal and time fields, as the JSON output does
+	tag.mode = 7;
+	nmea >> messages;
+
+	RAW raw = {Format::TXT, (void*)text.data(), (int)text.size()};
+	nmea.Receive(&raw, 1, tag);
+
+	int n = messages.list.size();
+	if (n == 0) {
+		fprintf(stderr, "no messages in %s\n", argv[1]);
+		return 1;
+	}
+
+	AIS::JSONAIS decoder;
+	Output output;
+	std::vector<std::string> documents;
+
+	decoder >> output;
+	documents.reserve(n);
+
+	// first pass warms up the reused storage and keeps the JSON for the parser
+	output.keep = &documents;
+	for (AIS::Message& m : messages.list) decoder.Receive(&m, 1, tag);
+	output.keep = nullptr;
+
+	long before = allocations;
+
+	for (int r = 0; r < repeat; r++)
+		for (AIS::Message& m : messages.list) decoder.Receive(&m, 1, tag);
+
+	double per_message = (double)(allocations - before) / ((double)repeat * n);
+
+	// as for JSON input in AIS::NMEA, the previous result is dropped before the next parse
+	JSON::Parser parser(&AIS::KeyMap, JSON_DICT_FULL);
+	parser.setSkipUnknown(true);
+
+	size_t properties = 0;
+	for (const std::string& d : documents) properties += parser.parse(d)->getProperties().size();
+
+	before = allocations;
+
+	for (int r = 0; r < repeat; r++)
+		for (const std::string& d : documents) properties += parser.parse(d)->getProperties().size();
+
+	double per_document = (double)(allocations - before) / ((double)repeat * documents.size());
+
+	printf("%d messages, %zu properties\n", n, properties);
+	printf("JSONAIS + stringify  %6.2f allocations/message\n", per_message);
+	printf("Parser               %6.2f allocations/document\n", per_document);
+
+	return 0;
+}
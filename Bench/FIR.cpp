@@ -0,0 +1,105 @@
+/*
+	Copyright(c) 2021-2025 jvde.github@gmail.com
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Microbenchmark for the FIR filters DSP::Filter, DSP::FilterComplex and DSP::DownsampleKFilter, built with -DBENCH=ON
+// usage: bench-fir [block size] [repetitions]
+
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "DSP.h"
+#include "Filters.h"
+
+template <typename S>
+class Sink : public StreamIn<S> {
+public:
+	S sum = 0.0f;
+
+	void Receive(const S* data, int len, TAG& tag) {
+		for (int i = 0; i < len; i++) sum += data[i];
+	}
+};
+
+// ns per input sample
+template <typename T, typename S>
+static double Run(T& filter, const std::vector<S>& input, int block, int repeat) {
+	TAG tag;
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	for (int r = 0; r < repeat; r++)
+		for (int i = 0; i + block <= (int)input.size(); i += block)
+			filter.Receive(input.data() + i, block, tag);
+
+	auto stop = std::chrono::high_resolution_clock::now();
+
+	double samples = (double)repeat * (input.size() / block * block);
+	return std::chrono::duration<double, std::nano>(stop - start).count() / samples;
+}
+
+int main(int argc, char* argv[]) {
+	int block = argc > 1 ? atoi(argv[1]) : 16384;
+	int repeat = argc > 2 ? atoi(argv[2]) : 50;
+
+	if (block <= 0 || repeat <= 0) {
+		fprintf(stderr, "usage: %s [block size] [repetitions]\n", argv[0]);
+		return 1;
+	}
+
+	// gaussian noise, the filters do the same work for any input
+	std::mt19937 gen(1);
+	std::normal_distribution<float> noise;
+	std::vector<FLOAT32> real(1 << 18);
+	std::vector<CFLOAT32> complex(1 << 18);
+
+	for (auto& x : real) x = noise(gen);
+	for (auto& x : complex) x = CFLOAT32(noise(gen), noise(gen));
+
+	struct Taps {
+		const char* name;
+		const std::vector<FLOAT32>& taps;
+	} sets[] = {{"Receiver", Filters::Receiver}, {"Coherent", Filters::Coherent}, {"BH_28_3", Filters::BlackmanHarris_28_3}};
+
+	for (const Taps& t : sets) {
+		DSP::Filter F;
+		DSP::FilterComplex FC;
+		DSP::DownsampleKFilter DSK;
+		Sink<FLOAT32> sink_f;
+		Sink<CFLOAT32> sink_fc, sink_dsk;
+
+		F.setTaps(t.taps);
+		FC.setTaps(t.taps);
+		DSK.setParams(t.taps, 3);
+
+		F >> sink_f;
+		FC >> sink_fc;
+		DSK >> sink_dsk;
+
+		double ns_f = Run(F, real, block, repeat);
+		double ns_fc = Run(FC, complex, block, repeat);
+		double ns_dsk = Run(DSK, complex, block, repeat);
+
+		printf("%-9s %2d taps: Filter %6.2f, FilterComplex %6.2f, DownsampleKFilter (K=3) %6.2f ns/sample (checksum %g)\n", t.name, (int)t.taps.size(),
+			   ns_f, ns_fc, ns_dsk, sink_f.sum + sink_fc.sum.real() + sink_dsk.sum.real());
+	}
+
+	return 0;
+}
@@ -0,0 +1,85 @@
+/*
+	Copyright(c) 2021-2025 jvde.github@gmail.com
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Microbenchmark for AIS::Message::buildNMEA and for copying messages into a queue, built with -DBENCH=ON
+// usage: bench-message [messages]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "Message.h"
+
+// called by the library on fatal errors, normally provided by the application
+void StopRequest() {}
+
+int main(int argc, char* argv[]) {
+	int count = argc > 1 ? atoi(argv[1]) : 1000000;
+
+	if (count <= 0) {
+		fprintf(stderr, "usage: %s [messages]\n", argv[0]);
+		return 1;
+	}
+
+	// random frames, a quarter of them the length of a type 5 (two sentences), the rest of a type 1
+	std::mt19937 gen(1);
+	std::vector<AIS::Message> frames(64);
+	TAG tag;
+
+	for (AIS::Message& m : frames) {
+		int len = gen() % 4 == 0 ? 424 : 168;
+
+		m.clear();
+		for (int i = 0; i < len; i++) m.setBit(i, gen() & 1);
+		m.setLength(len);
+		m.setChannel('A');
+	}
+
+	size_t sentences = 0;
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	for (int i = 0; i < count; i++) {
+		AIS::Message& m = frames[i & 63];
+		m.buildNMEA(tag);
+		sentences += m.NMEA.size();
+	}
+
+	auto stop = std::chrono::high_resolution_clock::now();
+	double build = std::chrono::duration<double>(stop - start).count();
+
+	// messages are passed on by value between threads, e.g. in the output queues
+	std::vector<AIS::Message> queue;
+	queue.reserve(1024);
+
+	start = std::chrono::high_resolution_clock::now();
+
+	for (int i = 0; i < count; i++) {
+		if (queue.size() == 1024) queue.clear();
+		queue.push_back(frames[i & 63]);
+	}
+
+	stop = std::chrono::high_resolution_clock::now();
+	double copy = std::chrono::duration<double>(stop - start).count();
+
+	printf("buildNMEA     %7.2f M msg/s (%zu sentences)\n", count / build / 1e6, sentences);
+	printf("copy message  %7.2f M msg/s (%zu queued)\n", count / copy / 1e6, queue.size());
+
+	return 0;
+}
@@ -0,0 +1,93 @@
+/*
+	Copyright(c) 2021-2025 jvde.github@gmail.com
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Microbenchmark for JSON::Parser on a recorded AIS-catcher JSON stream (one document per line,
+// e.g. the output of -o 5), built with -DBENCH=ON
+// usage: bench-parser <JSON file> [repetitions]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "Keys.h"
+#include "JSON/Parser.h"
+
+// called by the library on fatal errors, normally provided by the application
+void StopRequest() {}
+
+int main(int argc, char* argv[]) {
+	int repeat = argc > 2 ? atoi(argv[2]) : 50;
+	std::ifstream file(argc > 1 ? argv[1] : "");
+
+	if (!file || repeat <= 0) {
+		fprintf(stderr, "usage: %s <JSON file> [repetitions]\n", argv[0]);
+		return 1;
+	}
+
+	std::vector<std::string> lines;
+	std::string line;
+	size_t bytes = 0;
+
+	while (std::getline(file, line))
+		if (!line.empty()) {
+			bytes += line.size();
+			lines.push_back(line);
+		}
+
+	if (lines.empty()) {
+		fprintf(stderr, "no documents in %s\n", argv[1]);
+		return 1;
+	}
+
+	// as for JSON input in AIS::NMEA
+	JSON::Parser parser(&AIS::KeyMap, JSON_DICT_FULL);
+	parser.setSkipUnknown(true);
+
+	int errors = 0;
+	size_t properties = 0;
+
+	for (const std::string& l : lines) {
+		try {
+			properties += parser.parse(l)->getProperties().size();
+		}
+		catch (std::exception& e) {
+			if (errors++ == 0) fprintf(stderr, "%s\n", e.what());
+		}
+	}
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	for (int r = 0; r < repeat; r++)
+		for (const std::string& l : lines) {
+			try {
+				parser.parse(l);
+			}
+			catch (std::exception&) {
+			}
+		}
+
+	auto stop = std::chrono::high_resolution_clock::now();
+	double s = std::chrono::duration<double>(stop - start).count();
+
+	printf("%zu documents, %d errors, %zu properties\n", lines.size(), errors, properties);
+	printf("%7.2f us/doc %7.1f MB/s\n", s * 1e6 / ((double)repeat * lines.size()), (double)repeat * bytes / s / 1e6);
+
+	return 0;
+}
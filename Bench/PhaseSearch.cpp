@@ -0,0 +1,89 @@
+/*
+	Copyright(c) 2021-2025 jvde.github@gmail.com
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Microbenchmark for Demod::PhaseSearch and Demod::PhaseSearchEMA, built with -DBENCH=ON
+// usage: bench-phasesearch [block size] [repetitions]
+
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "Demod.h"
+
+class Sink : public StreamIn<FLOAT32> {
+public:
+	double sum = 0;
+
+	void Receive(const FLOAT32* data, int len, TAG& tag) {
+		for (int i = 0; i < len; i++) sum += data[i];
+	}
+};
+
+template <typename T>
+static double Run(T& search, const std::vector<CFLOAT32>& input, int block, int repeat) {
+	TAG tag;
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	for (int r = 0; r < repeat; r++)
+		for (int i = 0; i + block <= (int)input.size(); i += block)
+			search.Receive(input.data() + i, block, tag);
+
+	auto stop = std::chrono::high_resolution_clock::now();
+
+	double symbols = (double)repeat * (input.size() / block * block);
+	return std::chrono::duration<double, std::nano>(stop - start).count() / symbols;
+}
+
+int main(int argc, char* argv[]) {
+	int block = argc > 1 ? atoi(argv[1]) : 512;
+	int repeat = argc > 2 ? atoi(argv[2]) : 50;
+
+	if (block <= 0 || repeat <= 0) {
+		fprintf(stderr, "usage: %s [block size] [repetitions]\n", argv[0]);
+		return 1;
+	}
+
+	// complex gaussian noise, the search does the same work for any input
+	std::mt19937 gen(1);
+	std::normal_distribution<float> noise;
+	std::vector<CFLOAT32> input(1 << 16);
+
+	for (auto& x : input) x = CFLOAT32(noise(gen), noise(gen));
+
+	Demod::PhaseSearch PS;
+	Demod::PhaseSearchEMA EMA;
+	Sink sink_ps, sink_ema;
+
+	PS.setParams(12, 3);
+	EMA.setParams(3);
+
+	PS >> sink_ps;
+	EMA >> sink_ema;
+
+	double ns_ps = Run(PS, input, block, repeat);
+	double ns_ema = Run(EMA, input, block, repeat);
+
+	printf("PhaseSearch     %7.2f ns/symbol\n", ns_ps);
+	printf("PhaseSearchEMA  %7.2f ns/symbol\n", ns_ema);
+	printf("(checksum %g %g)\n", sink_ps.sum, sink_ema.sum);
+
+	return 0;
+}
@@ -0,0 +1,130 @@
+/*
+	Copyright(c) 2021-2025 jvde.github@gmail.com
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+// Microbenchmark for JSON::StringBuilder on recorded messages, built with -DBENCH=ON
+// usage: bench-stringbuilder <NMEA file> [repetitions]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "NMEA.h"
+#include "JSONAIS.h"
+#include "Keys.h"
+#include "JSON/StringBuilder.h"
+
+// called by the library on fatal errors, normally provided by the application
+void StopRequest() {}
+
+class Messages : public StreamIn<AIS::Message> {
+public:
+	std::vector<AIS::Message> list;
+
+	void Receive(const AIS::Message* data, int len, TAG& tag) {
+		for (int i = 0; i < len; i++) list.push_back(data[i]);
+	}
+};
+
+// keeps a materialized copy of the document, its values point into the JSONAIS that produced it
+class Document : public StreamIn<JSON::JSON> {
+public:
+	JSON::JSON json;
+
+	void Receive(const JSON::JSON* data, int len, TAG& tag) {
+		data[0].getProperties();
+		json = data[0];
+		json.setProducer(nullptr);
+	}
+};
+
+int main(int argc, char* argv[]) {
+	int repeat = argc > 2 ? atoi(argv[2]) : 100;
+	std::ifstream file(argc > 1 ? argv[1] : "");
+
+	if (!file || repeat <= 0) {
+		fprintf(stderr, "usage: %s <NMEA file> [repetitions]\n", argv[0]);
+		return 1;
+	}
+
+	std::stringstream ss;
+	ss << file.rdbuf();
+	std::string text = ss.str();
+
+	AIS::NMEA nmea;
+	Messages messages;
+	TAG tag;
+
+	// signal fields but no receive time, so the checksum can be compared between builds
+	tag.mode = 5;
+	nmea >> messages;
+
+	RAW raw = {Format::TXT, (void*)text.data(), (int)text.size()};
+	nmea.Receive(&raw, 1, tag);
+
+	int n = messages.list.size();
+	if (n == 0) {
+		fprintf(stderr, "no messages in %s\n", argv[1]);
+		return 1;
+	}
+
+	// one decoder per message so that every document stays valid
+	std::vector<AIS::JSONAIS> decoders(n);
+	std::vector<Document> documents(n);
+
+	for (int i = 0; i < n; i++) {
+		decoders[i] >> documents[i];
+		decoders[i].Receive(&messages.list[i], 1, tag);
+	}
+
+	printf("%d messages\n", n);
+
+	const int dicts[] = {JSON_DICT_FULL, JSON_DICT_MINIMAL, JSON_DICT_SPARSE};
+	const char* names[] = {"full", "minimal", "sparse"};
+
+	for (int d = 0; d < 3; d++) {
+		JSON::StringBuilder builder(&AIS::KeyMap, dicts[d]);
+		std::string json;
+		size_t bytes = 0, checksum = 0;
+
+		auto start = std::chrono::high_resolution_clock::now();
+
+		for (int r = 0; r < repeat; r++)
+			for (const Document& doc : documents) {
+				json.clear();
+				builder.stringify(doc.json, json);
+				bytes += json.size();
+			}
+
+		auto stop = std::chrono::high_resolution_clock::now();
+		double s = std::chrono::duration<double>(stop - start).count();
+
+		for (const Document& doc : documents) {
+			json.clear();
+			builder.stringify(doc.json, json);
+			checksum = checksum * 31 + std::hash<std::string>()(json);
+		}
+
+		printf("%-8s %7.1f ns/msg %7.1f MB/s (checksum %zx)\n", names[d], s * 1e9 / ((double)repeat * n), bytes / s / 1e6, checksum);
+	}
+
+	return 0;
+}
@@ -19,9 +19,11 @@
 #include <cassert>
 #include <complex>
 #include <cstring>
+#include <map>
+#include <mutex>
 
-#include "FFT.h"
 #include "DSP.h"
+#include "SIMD.h"
 
 namespace DSP {
 	void SimplePLL::Receive(const FLOAT32* data, int len, TAG& tag) {
@@ -55,6 +57,53 @@ namespace DSP {
 		}
 	}
 
+	// Block version of ScatterPLL::Receive: out[j] gets symbol j of every group completed in this call in one block.
+	// Symbol k of phase j has sample index tag.sample_idx + k * n + j and level tag.sample_lvls[k] (AIS::DecoderGroup)
+	void ScatterPLL::ReceiveBlocks(const CFLOAT32* data, int len, TAG& tag) {
+		const int n = (int)out.size();
+		const int groups = (lastSymbol + len) / n;
+
+		if (phases.size() < groups * n) phases.resize(groups * n);
+		if (levels.size() < groups) levels.resize(groups);
+
+		// group carried over from the previous call
+		for (int j = 0; j < lastSymbol && groups; j++) phases[j * groups] = sample[j];
+
+		for (int i = 0, g = 0; i < len; i++) {
+			if (g < groups)
+				phases[lastSymbol * groups + g] = data[i];
+			else
+				sample[lastSymbol] = data[i];
+
+			if (tag.mode & 1)
+				level += std::norm(data[i]);
+
+			if (++lastSymbol == n) {
+				if (tag.mode & 1)
+					levels[g] = level / n;
+
+				level = 0.0f;
+				lastSymbol = 0;
+				g++;
+			}
+		}
+
+		if (!groups) return;
+
+		tag.sample_idx = sample_idx - 1;
+		tag.sample_lvls = (tag.mode & 1) ? levels.data() : nullptr;
+
+		for (int j = 0; j < n; j++)
+			out[j].Send(&phases[j * groups], groups, tag);
+
+		sample_idx += groups * n;
+
+		tag.sample_idx = sample_idx - 1;
+		tag.sample_lvls = nullptr;
+		if (tag.mode & 1)
+			tag.sample_lvl = levels[groups - 1];
+	}
+
 	// Downsample moving average
 	void DownsampleMovingAverage::Receive(const CFLOAT32* data, int len, TAG& tag) {
 		if (output.size() < BLOCK_SIZE) output.resize(BLOCK_SIZE);
@@ -155,6 +204,129 @@ namespace DSP {
 		Send(output.data(), len, tag);
 	}
 
+	// FIR kernels. SSE2 and NEON are part of the x86-64 and AArch64 baselines so they are selected at compile time.
+	// Blocks of outputs are computed in parallel with each tap broadcast over the lanes, which avoids horizontal sums.
+	// Complex data is filtered as interleaved floats with a stride of two, both parts use the same (real) tap.
+#if defined(SIMD_SSE2)
+	typedef __m128 f32x4;
+
+	static inline f32x4 simd_load(const FLOAT32* p) { return _mm_loadu_ps(p); }
+	static inline void simd_store(FLOAT32* p, f32x4 a) { _mm_storeu_ps(p, a); }
+	static inline f32x4 simd_set1(FLOAT32 a) { return _mm_set1_ps(a); }
+	static inline f32x4 simd_zero() { return _mm_setzero_ps(); }
+	static inline f32x4 simd_add(f32x4 a, f32x4 b) { return _mm_add_ps(a, b); }
+	static inline f32x4 simd_mla(f32x4 acc, f32x4 a, f32x4 b) { return _mm_add_ps(acc, _mm_mul_ps(a, b)); }
+#elif defined(SIMD_NEON)
+	typedef float32x4_t f32x4;
+
+	static inline f32x4 simd_load(const FLOAT32* p) { return vld1q_f32(p); }
+	static inline void simd_store(FLOAT32* p, f32x4 a) { vst1q_f32(p, a); }
+	static inline f32x4 simd_set1(FLOAT32 a) { return vdupq_n_f32(a); }
+	static inline f32x4 simd_zero() { return vdupq_n_f32(0.0f); }
+	static inline f32x4 simd_add(f32x4 a, f32x4 b) { return vaddq_f32(a, b); }
+	static inline f32x4 simd_mla(f32x4 acc, f32x4 a, f32x4 b) { return vmlaq_f32(acc, a, b); }
+#endif
+
+#if defined(SIMD_SSE2) || defined(SIMD_NEON)
+	// y[m] = sum_k t[k] * x[m + S * k] for 16 consecutive floats m, folded: t[k] * (x[m + S * k] + x[m + S * (n - 1 - k)])
+	template <int S, bool SYMMETRIC>
+	static inline void FIRBlock16(const FLOAT32* t, int n, const FLOAT32* x, FLOAT32* y) {
+		const int h = SYMMETRIC ? n / 2 : n;
+
+		f32x4 a0 = simd_zero(), a1 = simd_zero(), a2 = simd_zero(), a3 = simd_zero();
+
+		for (int k = 0; k < h; k++) {
+			const FLOAT32* p = x + S * k;
+			f32x4 s0 = simd_load(p), s1 = simd_load(p + 4), s2 = simd_load(p + 8), s3 = simd_load(p + 12);
+
+			if (SYMMETRIC) {
+				const FLOAT32* q = x + S * (n - 1 - k);
+				s0 = simd_add(s0, simd_load(q));
+				s1 = simd_add(s1, simd_load(q + 4));
+				s2 = simd_add(s2, simd_load(q + 8));
+				s3 = simd_add(s3, simd_load(q + 12));
+			}
+
+			f32x4 tk = simd_set1(t[k]);
+			a0 = simd_mla(a0, tk, s0);
+			a1 = simd_mla(a1, tk, s1);
+			a2 = simd_mla(a2, tk, s2);
+			a3 = simd_mla(a3, tk, s3);
+		}
+
+		if (SYMMETRIC && (n & 1)) {
+			const FLOAT32* p = x + S * h;
+			f32x4 tk = simd_set1(t[h]);
+			a0 = simd_mla(a0, tk, simd_load(p));
+			a1 = simd_mla(a1, tk, simd_load(p + 4));
+			a2 = simd_mla(a2, tk, simd_load(p + 8));
+			a3 = simd_mla(a3, tk, simd_load(p + 12));
+		}
+
+		simd_store(y, a0);
+		simd_store(y + 4, a1);
+		simd_store(y + 8, a2);
+		simd_store(y + 12, a3);
+	}
+#endif
+
+	void FIR::set(const std::vector<FLOAT32>& t) {
+		int n = (int)t.size();
+
+		taps = t;
+		symmetric = n > 1;
+		for (int i = 0; i < n / 2; i++)
+			if (t[i] != t[n - 1 - i]) symmetric = false;
+
+		folded.assign(t.begin(), t.begin() + (symmetric ? (n + 1) / 2 : n));
+	}
+
+	FLOAT32 FIR::dot(const FLOAT32* data) const {
+		FLOAT32 x = 0.0f;
+		for (int i = 0; i < taps.size(); i++)
+			x += taps[i] * data[i];
+		return x;
+	}
+
+	CFLOAT32 FIR::dot(const CFLOAT32* data) const {
+		CFLOAT32 x = 0.0f;
+		for (int i = 0; i < taps.size(); i++)
+			x += taps[i] * data[i];
+		return x;
+	}
+
+	void FIR::filter(const FLOAT32* data, FLOAT32* out, int count) const {
+		int j = 0;
+
+#if defined(SIMD_SSE2) || defined(SIMD_NEON)
+		const int n = (int)taps.size();
+
+		for (; j + 16 <= count; j += 16) {
+			if (symmetric)
+				FIRBlock16<1, true>(folded.data(), n, data + j, out + j);
+			else
+				FIRBlock16<1, false>(folded.data(), n, data + j, out + j);
+		}
+#endif
+		for (; j < count; j++) out[j] = dot(data + j);
+	}
+
+	void FIR::filter(const CFLOAT32* data, CFLOAT32* out, int count) const {
+		int j = 0;
+
+#if defined(SIMD_SSE2) || defined(SIMD_NEON)
+		const int n = (int)taps.size();
+
+		for (; j + 8 <= count; j += 8) {
+			if (symmetric)
+				FIRBlock16<2, true>(folded.data(), n, (const FLOAT32*)(data + j), (FLOAT32*)(out + j));
+			else
+				FIRBlock16<2, false>(folded.data(), n, (const FLOAT32*)(data + j), (FLOAT32*)(out + j));
+		}
+#endif
+		for (; j < count; j++) out[j] = dot(data + j);
+	}
+
 	// Work in progress - needs performance improvement
 	void DownsampleKFilter::Receive(const CFLOAT32* data, int len, TAG& tag) {
 		int i, j;
@@ -167,7 +339,7 @@ namespace DSP {
 		for (i = 0, j = nt - 1; i < len; i++, j++) buffer[j] = data[i];
 
 		while (idx_in < len) {
-			output[idx_out] = dot(&buffer[idx_in]);
+			output[idx_out] = taps.dot(&buffer[idx_in]);
 
 			if (++idx_out == outputSize) {
 				Send(output.data(), outputSize, tag);
@@ -219,7 +391,7 @@ namespace DSP {
 					buffer[i - 1] = buffer[i];
 				buffer[taps.size() - 1] = data[j];
 
-				output[0] = dot(buffer.data());
+				output[0] = taps.dot(buffer.data());
 				Send(output.data(), 1, tag);
 			}
 			return;
@@ -227,12 +399,11 @@ namespace DSP {
 
 		for (j = 0, ptr = (int)taps.size() - 1; j < taps.size() - 1; ptr++, j++) {
 			buffer[ptr] = data[j];
-			output[j] = dot(&buffer[j]);
 		}
+		taps.filter(buffer.data(), output.data(), j);
 
-		for (i = 0; i < len - taps.size() + 1; i++, j++) {
-			output[j] = dot(&data[i]);
-		}
+		i = len - taps.size() + 1;
+		taps.filter(data, &output[j], i);
 
 		for (ptr = 0; i < len; i++, ptr++) {
 			buffer[ptr] = data[i];
@@ -253,7 +424,7 @@ namespace DSP {
 					buffer[i - 1] = buffer[i];
 				buffer[taps.size() - 1] = data[j];
 
-				output[0] = dot(buffer.data());
+				output[0] = taps.dot(buffer.data());
 				Send(output.data(), 1, tag);
 			}
 			return;
@@ -261,12 +432,11 @@ namespace DSP {
 
 		for (j = 0, ptr = (int)taps.size() - 1; j < taps.size() - 1; ptr++, j++) {
 			buffer[ptr] = data[j];
-			output[j] = dot(&buffer[j]);
 		}
+		taps.filter(buffer.data(), output.data(), j);
 
-		for (i = 0; i < len - taps.size() + 1; i++, j++) {
-			output[j] = dot(&data[i]);
-		}
+		i = len - taps.size() + 1;
+		taps.filter(data, &output[j], i);
 
 		for (ptr = 0; i < len; i++, ptr++) {
 			buffer[ptr] = data[i];
@@ -404,17 +574,152 @@ namespace DSP {
 	}
 
 
+	// zeroth order modified Bessel function for the Kaiser window
+	static double BesselI0(double x) {
+		double sum = 1.0, term = 1.0;
+		for (int k = 1; k < 50 && term > 1e-12 * sum; k++) {
+			term *= (x / (2.0 * k)) * (x / (2.0 * k));
+			sum += term;
+		}
+		return sum;
+	}
+
+	// sum_k t[2k] * x[k] over nt complex samples, taps duplicated so both I and Q use the same lanes
+	static inline CFLOAT32 ResampleDot(const FLOAT32* t, int nt, const FLOAT32* x) {
+#if defined(SIMD_SSE2) || defined(SIMD_NEON)
+		f32x4 a0 = simd_zero(), a1 = simd_zero(), a2 = simd_zero(), a3 = simd_zero();
+
+		for (int k = 0; k < 2 * nt; k += 16) {
+			a0 = simd_mla(a0, simd_load(t + k), simd_load(x + k));
+			a1 = simd_mla(a1, simd_load(t + k + 4), simd_load(x + k + 4));
+			a2 = simd_mla(a2, simd_load(t + k + 8), simd_load(x + k + 8));
+			a3 = simd_mla(a3, simd_load(t + k + 12), simd_load(x + k + 12));
+		}
+
+		FLOAT32 s[4];
+		simd_store(s, simd_add(simd_add(a0, a1), simd_add(a2, a3)));
+		return CFLOAT32(s[0] + s[2], s[1] + s[3]);
+#else
+		FLOAT32 re = 0.0f, im = 0.0f;
+		for (int k = 0; k < 2 * nt; k += 2) {
+			re += t[k] * x[k];
+			im += t[k] * x[k + 1];
+		}
+		return CFLOAT32(re, im);
+#endif
+	}
+
+	std::shared_ptr<const Resample::Bank> Resample::getBank(int in_rate, int out_rate, int L, int M, int P) {
+		static std::mutex mtx;
+		static std::map<std::pair<int, int>, std::shared_ptr<const Bank>> cache;
+
+		std::lock_guard<std::mutex> lock(mtx);
+
+		auto it = cache.find({ L, M });
+		if (it != cache.end()) return it->second;
+
+		// passband up to 0.365 x the lower rate, aliases only land in the transition band
+		const double attenuation = 60.0;
+		const double beta = 0.1102 * (attenuation - 8.7);
+		const double low = std::min(in_rate, out_rate);
+		const double cutoff = low / in_rate;
+		const double transition = 0.27 * low / in_rate;
+
+		int n = (int)std::ceil((attenuation - 7.95) / (2.285 * 2 * PI * transition)) + 1;
+		double C = n / 2.0;
+
+		// P < L: phases are rounded to the nearest of P + 1 fractional delays
+		int phases = P == L ? P : P + 1;
+
+		auto B = std::make_shared<Bank>();
+		B->nt = (n + 7) & ~7; // whole SIMD blocks, zero taps in front
+		B->taps.assign((size_t)phases * 2 * B->nt, 0.0f);
+
+		std::vector<double> g(n);
+
+		for (int p = 0; p < phases; p++) {
+			double f = (double)p / P, sum = 0.0;
+
+			for (int j = 0; j < n; j++) {
+				double d = j + f - C;
+				double x = PI * cutoff * d;
+				double r = d / C;
+				double w = BesselI0(beta * std::sqrt(std::max(0.0, 1.0 - r * r))) / BesselI0(beta);
+
+				g[j] = w * (x == 0 ? 1.0 : std::sin(x) / x);
+				sum += g[j];
+			}
+
+			// g[j] weighs the input j samples back, so it goes to position nt - 1 - j
+			FLOAT32* t = &B->taps[(size_t)p * 2 * B->nt];
+			for (int j = 0; j < n; j++)
+				t[2 * (B->nt - 1 - j)] = t[2 * (B->nt - 1 - j) + 1] = (FLOAT32)(g[j] / sum);
+		}
+
+		cache[{ L, M }] = B;
+		return B;
+	}
+
+	void Resample::setParams(int sample_rate, int out_rate) {
+		int a = sample_rate, b = out_rate;
+		while (b) {
+			int t = a % b;
+			a = b;
+			b = t;
+		}
+
+		L = out_rate / a;
+		M = sample_rate / a;
+		P = std::min(L, MAX_PHASES);
+
+		bank = getBank(sample_rate, out_rate, L, M, P);
+		nt = bank->nt;
+
+		buffer.assign(nt - 1, 0.0f);
+		output.resize(outputSize);
+		idx_in = idx_out = phase = 0;
+	}
+
+	void Resample::Receive(const CFLOAT32* data, int len, TAG& tag) {
+		const int h = nt - 1;
+		const FLOAT32* taps = bank->taps.data();
+
+		if (buffer.size() < len + h) buffer.resize(len + h, 0.0f);
+		std::copy(data, data + len, buffer.begin() + h);
+
+		// output at time idx_in + phase / L uses the nt input samples ending at idx_in
+		while (idx_in < len) {
+			int p = P == L ? phase : (int)(((int64_t)phase * P + L / 2) / L);
+
+			output[idx_out] = ResampleDot(taps + (size_t)p * 2 * nt, nt, (const FLOAT32*)&buffer[idx_in]);
+
+			if (++idx_out == outputSize) {
+				Send(output.data(), outputSize, tag);
+				idx_out = 0;
+			}
+
+			phase += M;
+			idx_in += phase / L;
+			phase %= L;
+		}
+
+		idx_in -= len;
+		std::copy(buffer.begin() + len, buffer.begin() + len + h, buffer.begin());
+	}
+
 	// square the signal, find the mid-point between two peaks
 	FLOAT32 SquareFreqOffsetCorrection::correctFrequency() {
 		FLOAT32 max_val = 0.0, fz = -1;
 		int delta = (int)(9600.0 / 48000.0 * N);
 		int wi = 0;
 
-		FFT::fft(fft_data);
+		plan.execute(fft_data);
 
-		if (wide) {
-			if (cumsum.size() < N) cumsum.resize(N);
+		// magnitudes with the zero frequency moved to the middle
+		for (int i = 0; i < N; i++)
+			magnitude[i] = std::abs(fft_data[(i + N / 2) % N]);
 
+		if (wide) {
 			int M = (int)(12500.0 / 48000.0 * N);
 			int ofs = (M - delta) / 2;
 
@@ -422,12 +727,11 @@ namespace DSP {
 
 			cumsum[0] = 0;
 			for (int i = 1; i < N; i++) {
-				FLOAT32 p = std::abs(fft_data[(i + N / 2) % N]);
-				cumsum[i] = cumsum[i - 1] + p;
+				cumsum[i] = cumsum[i - 1] + magnitude[i];
 			}
 
 			for (int i = 0; i < N - M; i++) {
-				FLOAT32 v = cumsum[i + M] - cumsum[i] + 0.6f * (std::abs(fft_data[(i + ofs + N / 2) % N]) + std::abs(fft_data[(i + ofs + delta + N / 2) % N]));
+				FLOAT32 v = cumsum[i + M] - cumsum[i] + 0.6f * (magnitude[(i + ofs) % N] + magnitude[(i + ofs + delta) % N]);
 				if (v > wm) {
 					wm = v;
 					wi = i;
@@ -437,7 +741,7 @@ namespace DSP {
 		}
 
 		for (int i = wi + window; i < wi + N - window - delta; i++) {
-			FLOAT32 h = std::abs(fft_data[(i + N / 2) % N]) + std::abs(fft_data[(i + delta + N / 2) % N]);
+			FLOAT32 h = magnitude[(i + N) % N] + magnitude[(i + delta + N) % N];
 
 			if (h > max_val) {
 				max_val = h;
@@ -459,16 +763,19 @@ namespace DSP {
 
 	void SquareFreqOffsetCorrection::setParams(int n, int w) {
 		N = n;
-		logN = FFT::log2(N);
 		window = w;
+
+		plan.init(N);
+		fft_data.assign(N, 0.0f);
+		magnitude.resize(N);
+		cumsum.resize(N);
+		output.resize(N);
+		count = 0;
 	}
 
 	void SquareFreqOffsetCorrection::Receive(const CFLOAT32* data, int len, TAG& tag) {
-		if (fft_data.size() < N) fft_data.resize(N);
-		if (output.size() < N) output.resize(N);
-
 		for (int i = 0; i < len; i++) {
-			fft_data[FFT::rev(count, logN)] = data[i] * data[i];
+			fft_data[plan.rev(count)] = data[i] * data[i];
 			output[count] = data[i];
 
 			if (++count == N) {
@@ -487,6 +794,259 @@ namespace DSP {
 	// Self invented so might be more clever approaches
 	// ----------------------------------------------------------------------------
 
+#if defined(SIMD_SSE2) || defined(SIMD_NEON)
+
+	// SSE2/NEON version: the decimating CIC5 is written in its equivalent FIR form
+	//   y[n] = E[n] + 5 (O[n-1] + E[n-2]) + 10 (E[n-1] + O[n-2]) + O[n-3], with E[n] = x[2n] and O[n] = x[2n+1]
+	// and four outputs are computed per iteration on the same packed I/Q words (as 16-bit lanes).
+	// As in the recursive form all sums stay below 2^16, so the results are identical.
+
+#if defined(SIMD_SSE2)
+	typedef __m128i u32x4;
+
+	static inline u32x4 cic_load(const uint32_t* p) { return _mm_loadu_si128((const __m128i*)p); }
+	static inline void cic_store(uint32_t* p, u32x4 a, int shift) { _mm_storeu_si128((__m128i*)p, _mm_srli_epi16(a, shift)); }
+
+	// 8 CU8/CS8 samples to 8 packed words
+	static inline void cic_load(const uint8_t* p, u32x4& a, u32x4& b) {
+		__m128i x = _mm_loadu_si128((const __m128i*)p);
+		a = _mm_unpacklo_epi8(x, _mm_setzero_si128());
+		b = _mm_unpackhi_epi8(x, _mm_setzero_si128());
+	}
+
+	static inline void cic_load(const int8_t* p, u32x4& a, u32x4& b) {
+		__m128i x = _mm_xor_si128(_mm_loadu_si128((const __m128i*)p), _mm_set1_epi8((char)0x80));
+		a = _mm_unpacklo_epi8(x, _mm_setzero_si128());
+		b = _mm_unpackhi_epi8(x, _mm_setzero_si128());
+	}
+
+	static inline void cic_store(CFLOAT32* p, u32x4 a, int shift) {
+		const __m128 scale = _mm_set1_ps(1.0f / 32768.0f);
+		__m128i x = _mm_xor_si128(_mm_srli_epi16(a, shift), _mm_set1_epi16((short)0x8000));
+
+		_mm_storeu_ps((float*)p, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16)), scale));
+		_mm_storeu_ps((float*)p + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16)), scale));
+	}
+
+	struct CIC5x4 {
+		u32x4 E, O; // previous even and odd inputs, most recent in the top lane
+
+		CIC5x4(const DS_UINT16::History& h) {
+			E = _mm_set_epi32((int)h.e1, (int)h.e2, 0, 0);
+			O = _mm_set_epi32((int)h.o1, (int)h.o2, (int)h.o3, 0);
+		}
+
+		void save(DS_UINT16::History& h) {
+			uint32_t e[4], o[4];
+			_mm_storeu_si128((__m128i*)e, E);
+			_mm_storeu_si128((__m128i*)o, O);
+			h.e1 = e[3], h.e2 = e[2];
+			h.o1 = o[3], h.o2 = o[2], h.o3 = o[1];
+		}
+
+		// 8 packed inputs to 4 packed outputs
+		inline u32x4 step(u32x4 a, u32x4 b) {
+			__m128i e = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(a), _mm_castsi128_ps(b), _MM_SHUFFLE(2, 0, 2, 0)));
+			__m128i o = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(a), _mm_castsi128_ps(b), _MM_SHUFFLE(3, 1, 3, 1)));
+
+			__m128i e1 = _mm_or_si128(_mm_slli_si128(e, 4), _mm_srli_si128(E, 12));
+			__m128i e2 = _mm_or_si128(_mm_slli_si128(e, 8), _mm_srli_si128(E, 8));
+			__m128i o1 = _mm_or_si128(_mm_slli_si128(o, 4), _mm_srli_si128(O, 12));
+			__m128i o2 = _mm_or_si128(_mm_slli_si128(o, 8), _mm_srli_si128(O, 8));
+			__m128i o3 = _mm_or_si128(_mm_slli_si128(o, 12), _mm_srli_si128(O, 4));
+
+			E = e;
+			O = o;
+
+			__m128i s1 = _mm_add_epi16(e, o3);
+			__m128i s5 = _mm_add_epi16(o1, e2);
+			__m128i s10 = _mm_add_epi16(e1, o2);
+
+			s5 = _mm_add_epi16(s5, _mm_slli_epi16(s5, 2));
+			s10 = _mm_add_epi16(s10, _mm_slli_epi16(s10, 2));
+
+			return _mm_add_epi16(_mm_add_epi16(s1, s5), _mm_add_epi16(s10, s10));
+		}
+	};
+#else
+	typedef uint32x4_t u32x4;
+
+	static inline u32x4 cic_load(const uint32_t* p) { return vld1q_u32(p); }
+	static inline void cic_store(uint32_t* p, u32x4 a, int shift) { vst1q_u32(p, vreinterpretq_u32_u16(vshlq_u16(vreinterpretq_u16_u32(a), vdupq_n_s16((int16_t)-shift)))); }
+
+	static inline void cic_load(const uint8_t* p, u32x4& a, u32x4& b) {
+		uint8x16_t x = vld1q_u8(p);
+		a = vreinterpretq_u32_u16(vmovl_u8(vget_low_u8(x)));
+		b = vreinterpretq_u32_u16(vmovl_u8(vget_high_u8(x)));
+	}
+
+	static inline void cic_load(const int8_t* p, u32x4& a, u32x4& b) {
+		uint8x16_t x = veorq_u8(vld1q_u8((const uint8_t*)p), vdupq_n_u8(0x80));
+		a = vreinterpretq_u32_u16(vmovl_u8(vget_low_u8(x)));
+		b = vreinterpretq_u32_u16(vmovl_u8(vget_high_u8(x)));
+	}
+
+	static inline void cic_store(CFLOAT32* p, u32x4 a, int shift) {
+		uint16x8_t y = vshlq_u16(vreinterpretq_u16_u32(a), vdupq_n_s16((int16_t)-shift));
+		int16x8_t x = vreinterpretq_s16_u16(veorq_u16(y, vdupq_n_u16(0x8000)));
+
+		vst1q_f32((float*)p, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(x))), 1.0f / 32768.0f));
+		vst1q_f32((float*)p + 4, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(x))), 1.0f / 32768.0f));
+	}
+
+	struct CIC5x4 {
+		u32x4 E, O; // previous even and odd inputs, most recent in the top lane
+
+		CIC5x4(const DS_UINT16::History& h) {
+			const uint32_t e[4] = { 0, 0, h.e2, h.e1 };
+			const uint32_t o[4] = { 0, h.o3, h.o2, h.o1 };
+			E = vld1q_u32(e);
+			O = vld1q_u32(o);
+		}
+
+		void save(DS_UINT16::History& h) {
+			uint32_t e[4], o[4];
+			vst1q_u32(e, E);
+			vst1q_u32(o, O);
+			h.e1 = e[3], h.e2 = e[2];
+			h.o1 = o[3], h.o2 = o[2], h.o3 = o[1];
+		}
+
+		// 8 packed inputs to 4 packed outputs
+		inline u32x4 step(u32x4 a, u32x4 b) {
+			uint32x4x2_t eo = vuzpq_u32(a, b);
+			uint32x4_t e = eo.val[0], o = eo.val[1];
+
+			uint16x8_t e1 = vreinterpretq_u16_u32(vextq_u32(E, e, 3));
+			uint16x8_t e2 = vreinterpretq_u16_u32(vextq_u32(E, e, 2));
+			uint16x8_t o1 = vreinterpretq_u16_u32(vextq_u32(O, o, 3));
+			uint16x8_t o2 = vreinterpretq_u16_u32(vextq_u32(O, o, 2));
+			uint16x8_t o3 = vreinterpretq_u16_u32(vextq_u32(O, o, 1));
+
+			E = e;
+			O = o;
+
+			uint16x8_t s1 = vaddq_u16(vreinterpretq_u16_u32(e), o3);
+			uint16x8_t s5 = vaddq_u16(o1, e2);
+			uint16x8_t s10 = vaddq_u16(e1, o2);
+
+			s5 = vaddq_u16(s5, vshlq_n_u16(s5, 2));
+			s10 = vaddq_u16(s10, vshlq_n_u16(s10, 2));
+
+			return vreinterpretq_u32_u16(vaddq_u16(vaddq_u16(s1, s5), vaddq_u16(s10, s10)));
+		}
+	};
+#endif
+
+	// scalar FIR step for the remainder, on packed words
+	inline uint32_t DS_UINT16::FIR(uint32_t e, uint32_t o) {
+		uint32_t y = e + history.o3 + 5 * (history.o1 + history.e2) + 10 * (history.e1 + history.o2);
+
+		history.e2 = history.e1;
+		history.e1 = e;
+		history.o3 = history.o2;
+		history.o2 = history.o1;
+		history.o1 = o;
+
+		return y;
+	}
+
+	int DS_UINT16::Run(uint32_t* data, int len, int shift) {
+		uint32_t mask = 0xFFFFU >> shift;
+		mask |= mask << 16;
+
+		len >>= 1;
+
+		// in place is safe: outputs i..i+3 are written after inputs 2i..2i+7 are read
+		CIC5x4 cic(history);
+		int i = 0;
+
+		for (; i + 4 <= len; i += 4) {
+			u32x4 y = cic.step(cic_load(data + 2 * i), cic_load(data + 2 * i + 4));
+			cic_store(data + i, y, shift);
+		}
+		cic.save(history);
+
+		for (; i < len; i++)
+			data[i] = (FIR(data[2 * i], data[2 * i + 1]) >> shift) & mask;
+
+		return len;
+	}
+
+	int DS_UINT16::Run(uint8_t* in, uint32_t* out, int len, int shift) {
+		uint32_t mask = 0xFFFFU >> shift;
+		mask |= mask << 16;
+
+		len >>= 1;
+
+		CIC5x4 cic(history);
+		int i = 0;
+
+		for (; i + 4 <= len; i += 4) {
+			u32x4 a, b;
+			cic_load(in + 4 * i, a, b);
+			cic_store(out + i, cic.step(a, b), shift);
+		}
+		cic.save(history);
+
+		for (; i < len; i++) {
+			uint32_t e = (uint32_t)in[4 * i] | (uint32_t)in[4 * i + 1] << 16;
+			uint32_t o = (uint32_t)in[4 * i + 2] | (uint32_t)in[4 * i + 3] << 16;
+			out[i] = (FIR(e, o) >> shift) & mask;
+		}
+		return len;
+	}
+
+	int DS_UINT16::Run(int8_t* in, uint32_t* out, int len, int shift) {
+		uint32_t mask = 0xFFFFU >> shift;
+		mask |= mask << 16;
+		const uint32_t mask_uint = (1 << 7) | (1 << 23);
+
+		len >>= 1;
+
+		CIC5x4 cic(history);
+		int i = 0;
+
+		for (; i + 4 <= len; i += 4) {
+			u32x4 a, b;
+			cic_load(in + 4 * i, a, b);
+			cic_store(out + i, cic.step(a, b), shift);
+		}
+		cic.save(history);
+
+		for (; i < len; i++) {
+			uint32_t e = ((uint32_t)(uint8_t)in[4 * i] | (uint32_t)(uint8_t)in[4 * i + 1] << 16) ^ mask_uint;
+			uint32_t o = ((uint32_t)(uint8_t)in[4 * i + 2] | (uint32_t)(uint8_t)in[4 * i + 3] << 16) ^ mask_uint;
+			out[i] = (FIR(e, o) >> shift) & mask;
+		}
+		return len;
+	}
+
+	int DS_UINT16::Run(uint32_t* in, CFLOAT32* out, int len, int shift) {
+		uint32_t mask = 0xFFFFU >> shift;
+		mask |= mask << 16;
+		const uint32_t mask_uint = (1U << 15) | (1U << 31);
+
+		len >>= 1;
+
+		CIC5x4 cic(history);
+		int i = 0;
+
+		for (; i + 4 <= len; i += 4) {
+			u32x4 y = cic.step(cic_load(in + 2 * i), cic_load(in + 2 * i + 4));
+			cic_store(out + i, y, shift);
+		}
+		cic.save(history);
+
+		for (; i < len; i++) {
+			uint32_t z = ((FIR(in[2 * i], in[2 * i + 1]) >> shift) & mask) ^ mask_uint;
+			out[i].real(((int16_t)(z & 0xFFFFU)) / 32768.0f);
+			out[i].imag(((int16_t)(z >> 16)) / 32768.0f);
+		}
+		return len;
+	}
+
+#else
 	int DS_UINT16::Run(uint32_t* data, int len, int shift) {
 		uint32_t z, r0, r1, r2, r3, r4;
 		uint32_t mask = 0xFFFFU >> shift;
@@ -603,39 +1163,45 @@ namespace DSP {
 		}
 		return len;
 	}
+#endif
 
-	// Multi-pass aggregators
-	void Downsample32_CU8::Receive(const CU8* data, int len, TAG& tag) {
-		assert(len % 32 == 0);
+	// Multi-pass aggregators, all stages are run per chunk of the input so the intermediate buffer stays in cache
+	template <typename T>
+	static int DownsampleFixedPoint(T* in, int len, DS_UINT16* DS, int stages, std::vector<uint32_t>& buffer, CFLOAT32* out) {
+		const int CHUNK = 8192;
+		const int shift[] = { 3, 4, 5, 5 };
 
-		if (output.size() < len / 32) output.resize(len / 32);
-		if (buffer.size() < len / 2) buffer.resize(len / 2);
+		if (buffer.size() < CHUNK / 2) buffer.resize(CHUNK / 2);
 
 		uint32_t* buf = buffer.data();
+		int count = 0;
 
-		len = DS1.Run((uint8_t*)data, buf, len, 3);
-		len = DS2.Run(buf, len, 4);
-		len = DS3.Run(buf, len, 5);
-		len = DS4.Run(buf, len, 5);
-		len = DS5.Run(buf, output.data(), len, 0);
+		for (int i = 0; i < len; i += CHUNK) {
+			int n = MIN(CHUNK, len - i);
 
-		out.Send(output.data(), len, tag);
+			n = DS[0].Run(in + 2 * i, buf, n, shift[0]);
+			for (int s = 1; s < stages - 1; s++)
+				n = DS[s].Run(buf, n, shift[s]);
+			count += DS[stages - 1].Run(buf, out + count, n, 0);
+		}
+		return count;
 	}
 
-	void Downsample32_CS8::Receive(const CS8* data, int len, TAG& tag) {
+	void Downsample32_CU8::Receive(const CU8* data, int len, TAG& tag) {
 		assert(len % 32 == 0);
 
 		if (output.size() < len / 32) output.resize(len / 32);
-		if (buffer.size() < len / 2) buffer.resize(len / 2);
 
-		uint32_t* buf = buffer.data();
+		len = DownsampleFixedPoint((uint8_t*)data, len, DS, 5, buffer, output.data());
+		out.Send(output.data(), len, tag);
+	}
 
-		len = DS1.Run((int8_t*)data, buf, len, 3);
-		len = DS2.Run(buf, len, 4);
-		len = DS3.Run(buf, len, 5);
-		len = DS4.Run(buf, len, 5);
-		len = DS5.Run(buf, output.data(), len, 0);
+	void Downsample32_CS8::Receive(const CS8* data, int len, TAG& tag) {
+		assert(len % 32 == 0);
 
+		if (output.size() < len / 32) output.resize(len / 32);
+
+		len = DownsampleFixedPoint((int8_t*)data, len, DS, 5, buffer, output.data());
 		out.Send(output.data(), len, tag);
 	}
 
@@ -643,15 +1209,8 @@ namespace DSP {
 		assert(len % 16 == 0);
 
 		if (output.size() < len / 16) output.resize(len / 16);
-		if (buffer.size() < len / 2) buffer.resize(len / 2);
-
-		uint32_t* buf = buffer.data();
-
-		len = DS1.Run((uint8_t*)data, buf, len, 3);
-		len = DS2.Run(buf, len, 4);
-		len = DS3.Run(buf, len, 5);
-		len = DS4.Run(buf, output.data(), len, 0);
 
+		len = DownsampleFixedPoint((uint8_t*)data, len, DS, 4, buffer, output.data());
 		out.Send(output.data(), len, tag);
 	}
 
@@ -659,15 +1218,8 @@ namespace DSP {
 		assert(len % 16 == 0);
 
 		if (output.size() < len / 16) output.resize(len / 16);
-		if (buffer.size() < len / 2) buffer.resize(len / 2);
-
-		uint32_t* buf = buffer.data();
-
-		len = DS1.Run((int8_t*)data, buf, len, 3);
-		len = DS2.Run(buf, len, 4);
-		len = DS3.Run(buf, len, 5);
-		len = DS4.Run(buf, output.data(), len, 0);
 
+		len = DownsampleFixedPoint((int8_t*)data, len, DS, 4, buffer, output.data());
 		out.Send(output.data(), len, tag);
 	}
 
@@ -675,14 +1227,8 @@ namespace DSP {
 		assert(len % 8 == 0);
 
 		if (output.size() < len / 8) output.resize(len / 8);
-		if (buffer.size() < len / 2) buffer.resize(len / 2);
-
-		uint32_t* buf = buffer.data();
-
-		len = DS1.Run((uint8_t*)data, buf, len, 3);
-		len = DS2.Run(buf, len, 4);
-		len = DS3.Run(buf, output.data(), len, 0);
 
+		len = DownsampleFixedPoint((uint8_t*)data, len, DS, 3, buffer, output.data());
 		out.Send(output.data(), len, tag);
 	}
 
@@ -690,14 +1236,8 @@ namespace DSP {
 		assert(len % 8 == 0);
 
 		if (output.size() < len / 8) output.resize(len / 8);
-		if (buffer.size() < len / 2) buffer.resize(len / 2);
-
-		uint32_t* buf = buffer.data();
-
-		len = DS1.Run((int8_t*)data, buf, len, 3);
-		len = DS2.Run(buf, len, 4);
-		len = DS3.Run(buf, output.data(), len, 0);
 
+		len = DownsampleFixedPoint((int8_t*)data, len, DS, 3, buffer, output.data());
 		out.Send(output.data(), len, tag);
 	}
 }
\ No newline at end of file
@@ -18,6 +18,7 @@
 #pragma once
 
 #include <assert.h>
+#include <memory>
 #ifdef HASSOXR
 #include <soxr.h>
 #endif
@@ -25,6 +26,7 @@
 #include <samplerate.h>
 #endif
 #include "Filters.h"
+#include "FFT.h"
 
 #include "Stream.h"
 #include "Signals.h"
@@ -79,6 +81,13 @@ namespace DSP
 		FLOAT32 level = 0.0f;
 		long sample_idx = 0;
 
+		// block mode: symbols of the complete groups stored per phase, and the level of each group
+		bool blocks = false;
+		std::vector<CFLOAT32> phases;
+		std::vector<FLOAT32> levels;
+
+		void ReceiveBlocks(const CFLOAT32 *data, int len, TAG &tag);
+
 	public:
 		virtual ~ScatterPLL() {}
 		void setConnections(int n)
@@ -87,12 +96,21 @@ namespace DSP
 			sample.resize(n);
 		}
 
+		// send all symbols of a phase in one call instead of one symbol per phase in turn
+		void setBlocks(bool b) { blocks = b; }
+
 		// Streams out
 		std::vector<Connection<CFLOAT32>> out;
 
 		// Streams in
 		void Receive(const CFLOAT32 *data, int len, TAG &tag)
 		{
+			if (blocks)
+			{
+				ReceiveBlocks(data, len, tag);
+				return;
+			}
+
 			for (int i = 0; i < len; i++)
 			{
 				sample[lastSymbol] = data[i];
@@ -177,12 +195,33 @@ namespace DSP
 		void Receive(const CFLOAT32 *data, int len, TAG &tag);
 	};
 
+	// FIR taps and kernels (SSE2/NEON where available), symmetric filters (all tables in Filters.h)
+	// are folded so each tap is multiplied once
+	class FIR
+	{
+		std::vector<FLOAT32> taps;
+		std::vector<FLOAT32> folded; // taps[0..n/2) followed by the middle tap for odd n, or all taps if not symmetric
+		bool symmetric = false;
+
+	public:
+		void set(const std::vector<FLOAT32> &t);
+		int size() const { return (int)taps.size(); }
+
+		// single output from data[0..n)
+		FLOAT32 dot(const FLOAT32 *data) const;
+		CFLOAT32 dot(const CFLOAT32 *data) const;
+
+		// out[j] = dot(data + j) for j < count
+		void filter(const FLOAT32 *data, FLOAT32 *out, int count) const;
+		void filter(const CFLOAT32 *data, CFLOAT32 *out, int count) const;
+	};
+
 	class DownsampleKFilter : public SimpleStreamInOut<CFLOAT32, CFLOAT32>
 	{
 		std::vector<CFLOAT32> output;
 
 		std::vector<CFLOAT32> buffer;
-		std::vector<FLOAT32> taps;
+		FIR taps;
 
 		int idx_in = 0;
 		int idx_out = 0;
@@ -191,22 +230,14 @@ namespace DSP
 
 		static const int outputSize = 16384 / 2;
 
-		inline CFLOAT32 dot(const CFLOAT32 *data)
-		{
-			CFLOAT32 x = 0.0f;
-			for (int i = 0; i < taps.size(); i++)
-				x += taps[i] * *data++;
-			return x;
-		}
-
 	public:
 		virtual ~DownsampleKFilter() {}
 		void setParams(const std::vector<FLOAT32> &t, int k)
 		{
-			taps = t;
+			taps.set(t);
 			K = k;
 		}
-		void setTaps(const std::vector<FLOAT32> &t) { taps = t; }
+		void setTaps(const std::vector<FLOAT32> &t) { taps.set(t); }
 		void setK(int k) { K = k; }
 
 		// StreamIn
@@ -218,22 +249,14 @@ namespace DSP
 		std::vector<CFLOAT32> output;
 
 		std::vector<CFLOAT32> buffer;
-		std::vector<FLOAT32> taps;
-
-		inline CFLOAT32 dot(const CFLOAT32 *data)
-		{
-			CFLOAT32 x = 0.0f;
-			for (int i = 0; i < taps.size(); i++)
-				x += taps[i] * *data++;
-			return x;
-		}
+		FIR taps;
 
 	public:
 		virtual ~FilterComplex() {}
 
 		void setTaps(const std::vector<FLOAT32> &t)
 		{
-			taps = t;
+			taps.set(t);
 			buffer.resize(taps.size() * 2, 0.0f);
 		}
 
@@ -245,22 +268,13 @@ namespace DSP
 	{
 		std::vector<FLOAT32> output;
 		std::vector<FLOAT32> buffer;
-		std::vector<FLOAT32> taps;
-
-		inline FLOAT32 dot(const FLOAT32 *data)
-		{
-			FLOAT32 x = 0.0f;
-			for (int i = 0; i < taps.size(); i++)
-				x += taps[i] * *data++;
-
-			return x;
-		}
+		FIR taps;
 
 	public:
 		virtual ~Filter() {}
 		void setTaps(const std::vector<FLOAT32> &t)
 		{
-			taps = t;
+			taps.set(t);
 			buffer.resize(taps.size() * 2, 0.0f);
 		}
 
@@ -360,15 +374,53 @@ namespace DSP
 		virtual void Receive(const CFLOAT32 *data, int len, TAG &tag);
 	};
 
+	// Polyphase rational resampler, any input rate to out_rate in a single pass. The Kaiser windowed sinc
+	// prototype is split into one FIR per phase; banks are built once per ratio and shared between instances
+	class Resample : public SimpleStreamInOut<CFLOAT32, CFLOAT32>
+	{
+		// phases stored back to back, taps oldest first and duplicated to line up with interleaved I/Q
+		struct Bank
+		{
+			int nt = 0;
+			std::vector<FLOAT32> taps;
+		};
+		std::shared_ptr<const Bank> bank;
+
+		std::vector<CFLOAT32> output;
+		std::vector<CFLOAT32> buffer;
+
+		int L = 1, M = 1; // out_rate / in_rate = L / M
+		int P = 1;		  // phases in the bank, equal to L unless L > MAX_PHASES
+		int nt = 1;
+
+		int idx_in = 0;
+		int idx_out = 0;
+		int phase = 0;
+
+		static const int outputSize = 16384;
+		static const int MAX_PHASES = 512;
+
+		static std::shared_ptr<const Bank> getBank(int in_rate, int out_rate, int L, int M, int P);
+
+	public:
+		virtual ~Resample() {}
+		void setParams(int sample_rate, int out_rate);
+
+		// StreamIn
+		void Receive(const CFLOAT32 *data, int len, TAG &tag);
+	};
+
 	class SquareFreqOffsetCorrection : public SimpleStreamInOut<CFLOAT32, CFLOAT32>
 	{
 		std::vector<CFLOAT32> output;
 		std::vector<CFLOAT32> fft_data;
 		std::vector<FLOAT32> cumsum;
+		std::vector<FLOAT32> magnitude;
+
+		FFT::Plan<FLOAT32> plan;
 
 		CFLOAT32 rot = 1.0f;
 		int N = 2048;
-		int logN = 11;
 		int count = 0;
 		int window = 750;
 		bool wide = false;
@@ -384,7 +436,18 @@ namespace DSP
 
 	class DS_UINT16
 	{
+	public:
+		// previous even (e) and odd (o) inputs for the FIR form used by the SSE2/NEON version
+		struct History
+		{
+			uint32_t e1 = 0, e2 = 0, o1 = 0, o2 = 0, o3 = 0;
+		};
+
+	private:
 		uint32_t h0 = 0, h1 = 0, h2 = 0, h3 = 0, h4 = 0;
+		History history;
+
+		inline uint32_t FIR(uint32_t e, uint32_t o);
 
 	public:
 		int Run(uint32_t *, int, int);
@@ -398,7 +461,7 @@ namespace DSP
 		std::vector<CFLOAT32> output;
 		std::vector<uint32_t> buffer;
 
-		DS_UINT16 DS1, DS2, DS3, DS4, DS5;
+		DS_UINT16 DS[5];
 
 	public:
 		virtual ~Downsample32_CU8() {}
@@ -410,7 +473,7 @@ namespace DSP
 		std::vector<CFLOAT32> output;
 		std::vector<uint32_t> buffer;
 
-		DS_UINT16 DS1, DS2, DS3, DS4, DS5;
+		DS_UINT16 DS[5];
 
 	public:
 		virtual ~Downsample32_CS8() {}
@@ -422,7 +485,7 @@ namespace DSP
 		std::vector<CFLOAT32> output;
 		std::vector<uint32_t> buffer;
 
-		DS_UINT16 DS1, DS2, DS3, DS4;
+		DS_UINT16 DS[4];
 
 	public:
 		virtual ~Downsample16_CU8() {}
@@ -434,7 +497,7 @@ namespace DSP
 		std::vector<CFLOAT32> output;
 		std::vector<uint32_t> buffer;
 
-		DS_UINT16 DS1, DS2, DS3, DS4;
+		DS_UINT16 DS[4];
 
 	public:
 		void Receive(const CS8 *data, int len, TAG &tag);
@@ -445,7 +508,7 @@ namespace DSP
 		std::vector<CFLOAT32> output;
 		std::vector<uint32_t> buffer;
 
-		DS_UINT16 DS1, DS2, DS3;
+		DS_UINT16 DS[3];
 
 	public:
 		virtual ~Downsample8_CU8() {}
@@ -457,7 +520,7 @@ namespace DSP
 		std::vector<CFLOAT32> output;
 		std::vector<uint32_t> buffer;
 
-		DS_UINT16 DS1, DS2, DS3;
+		DS_UINT16 DS[3];
 
 	public:
 		virtual ~Downsample8_CS8() {}
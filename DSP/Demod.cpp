@@ -21,6 +21,7 @@
 
 #include "Demod.h"
 #include "DSP.h"
+#include "SIMD.h"
 
 namespace Demod {
 
@@ -36,48 +37,132 @@ namespace Demod {
 		Send(output.data(), len, tag);
 	}
 
-	void PhaseSearchEMA::Receive(const CFLOAT32* data, int len, TAG& tag) {
-		for (int i = 0; i < len; i++) {
-			FLOAT32 re = 0, im = 0;
+	// The phase searches project each symbol on 16 rotations: lane j < 8 is re * cos + im * sin of phase[j],
+	// lane j >= 8 uses phase[15 - j] with the sign of the sine flipped. All phases are processed side by side.
+	struct PhaseTable {
+		FLOAT32 re[nPhases], im[nPhases];
 
-			//  multiply samples with (1j) ** i, to get all points on the same line
-			switch (rot) {
-			case 0:
-				re = data[i].real();
-				im = data[i].imag();
-				break;
-			case 1:
-				im = data[i].real();
-				re = -data[i].imag();
-				break;
-			case 2:
-				re = -data[i].real();
-				im = -data[i].imag();
-				break;
-			case 3:
-				im = -data[i].real();
-				re = data[i].imag();
-				break;
+		PhaseTable() {
+			for (int j = 0; j < nPhases / 2; j++) {
+				re[j] = re[nPhases - 1 - j] = phase[j].real();
+				im[j] = phase[j].imag();
+				im[nPhases - 1 - j] = -phase[j].imag();
 			}
+		}
+	};
+
+	static const PhaseTable table;
+
+#if defined(SIMD_SSE2)
+	typedef __m128 f32x4;
+
+	static inline f32x4 simd_load(const FLOAT32* p) { return _mm_loadu_ps(p); }
+	static inline void simd_store(FLOAT32* p, f32x4 a) { _mm_storeu_ps(p, a); }
+	static inline f32x4 simd_set1(FLOAT32 a) { return _mm_set1_ps(a); }
+	static inline f32x4 simd_add(f32x4 a, f32x4 b) { return _mm_add_ps(a, b); }
+	static inline f32x4 simd_mul(f32x4 a, f32x4 b) { return _mm_mul_ps(a, b); }
+	static inline f32x4 simd_abs(f32x4 a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+	static inline int simd_positive(f32x4 a) { return _mm_movemask_ps(_mm_cmpgt_ps(a, _mm_setzero_ps())); }
+
+	// inf and nan (all exponent bits set) to zero
+	static inline f32x4 simd_finite(f32x4 a) {
+		const __m128i e = _mm_set1_epi32(0x7f800000);
+		__m128 bad = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(_mm_castps_si128(a), e), e));
+		return _mm_andnot_ps(bad, a);
+	}
+#elif defined(SIMD_NEON)
+	typedef float32x4_t f32x4;
+
+	static inline f32x4 simd_load(const FLOAT32* p) { return vld1q_f32(p); }
+	static inline void simd_store(FLOAT32* p, f32x4 a) { vst1q_f32(p, a); }
+	static inline f32x4 simd_set1(FLOAT32 a) { return vdupq_n_f32(a); }
+	static inline f32x4 simd_add(f32x4 a, f32x4 b) { return vaddq_f32(a, b); }
+	static inline f32x4 simd_mul(f32x4 a, f32x4 b) { return vmulq_f32(a, b); }
+	static inline f32x4 simd_abs(f32x4 a) { return vabsq_f32(a); }
+
+	static inline int simd_positive(f32x4 a) {
+		static const uint32_t w[4] = { 1, 2, 4, 8 };
+		uint32x4_t m = vandq_u32(vcgtq_f32(a, vdupq_n_f32(0.0f)), vld1q_u32(w));
+		uint32x2_t s = vadd_u32(vget_low_u32(m), vget_high_u32(m));
+		return (int)vget_lane_u32(vpadd_u32(s, s), 0);
+	}
 
-			rot = (rot + 1) & 3;
+	static inline f32x4 simd_finite(f32x4 a) {
+		const uint32x4_t e = vdupq_n_u32(0x7f800000);
+		uint32x4_t bad = vceqq_u32(vandq_u32(vreinterpretq_u32_f32(a), e), e);
+		return vreinterpretq_f32_u32(vbicq_u32(vreinterpretq_u32_f32(a), bad));
+	}
+#endif
+
+	//  multiply samples with (1j) ** rot, to get all points on the same line
+	static inline void Rotate(const CFLOAT32& x, int rot, FLOAT32& re, FLOAT32& im) {
+		switch (rot) {
+		case 0:
+			re = x.real();
+			im = x.imag();
+			break;
+		case 1:
+			im = x.real();
+			re = -x.imag();
+			break;
+		case 2:
+			re = -x.real();
+			im = -x.imag();
+			break;
+		default:
+			im = -x.real();
+			re = x.imag();
+			break;
+		}
+	}
 
-			// Determining the phase is approached as a linear classification problem.
-			for (int j = 0; j < nPhases / 2; j++) {
-				FLOAT32 t, a = re * phase[j].real(), b = im * phase[j].imag();
+	// a[j] = |projection on phase j|, returns the signs of the projections as bits
+	static inline int Project(FLOAT32 re, FLOAT32 im, FLOAT32* a) {
+		int signs = 0;
+
+#if defined(SIMD_SSE2) || defined(SIMD_NEON)
+		f32x4 r = simd_set1(re), i = simd_set1(im);
+
+		for (int j = 0; j < nPhases; j += 4) {
+			f32x4 t = simd_add(simd_mul(r, simd_load(table.re + j)), simd_mul(i, simd_load(table.im + j)));
+			signs |= simd_positive(t) << j;
+			simd_store(a + j, simd_abs(t));
+		}
+#else
+		for (int j = 0; j < nPhases; j++) {
+			FLOAT32 t = re * table.re[j] + im * table.im[j];
+			signs |= (t > 0) << j;
+			a[j] = std::abs(t);
+		}
+#endif
+		return signs;
+	}
 
-				t = a + b;
-				bits[j] = (bits[j] << 1) | (t > 0);
-				ma[j] = weight * ma[j] + (1 - weight) * std::abs(t);
+	void PhaseSearchEMA::Receive(const CFLOAT32* data, int len, TAG& tag) {
+		if (output.size() < len) output.resize(len);
 
-				t = a - b;
-				bits[nPhases - 1 - j] = (bits[nPhases - 1 - j] << 1) | (t > 0);
-				ma[nPhases - 1 - j] = weight * ma[nPhases - 1 - j] + (1 - weight) * std::abs(t);
+		const FLOAT32 w = weight, v = 1 - weight;
+		FLOAT32 a[nPhases];
 
-				// prevent error propagation of inf and nan in input
+		for (int i = 0; i < len; i++) {
+			FLOAT32 re = 0, im = 0;
+
+			Rotate(data[i], rot, re, im);
+			rot = (rot + 1) & 3;
+
+			// Determining the phase is approached as a linear classification problem.
+			signs[symbol] = Project(re, im, a);
+
+			// prevent error propagation of inf and nan in input
+#if defined(SIMD_SSE2) || defined(SIMD_NEON)
+			for (int j = 0; j < nPhases; j += 4)
+				simd_store(ma + j, simd_finite(simd_add(simd_mul(simd_set1(w), simd_load(ma + j)), simd_mul(simd_set1(v), simd_load(a + j)))));
+#else
+			for (int j = 0; j < nPhases; j++) {
+				ma[j] = w * ma[j] + v * a[j];
 				if (std::isinf(ma[j]) || std::isnan(ma[j])) ma[j] = 0;
-				if (std::isinf(ma[nPhases - 1 - j]) || std::isnan(ma[nPhases - 1 - j])) ma[nPhases - 1 - j] = 0;
 			}
+#endif
 
 			// we look at previous [max_idx - nSearch, max_idx + nSearch]
 			int idx = (max_idx - nSearch + nPhases) & (nPhases - 1);
@@ -95,57 +180,55 @@ namespace Demod {
 			}
 
 			// determine the bit
-			bool b2 = (bits[max_idx] >> (nDelay + 1)) & 1;
-			bool b1 = (bits[max_idx] >> nDelay) & 1;
+			bool b2 = (signs[(symbol - nDelay - 1) & (nSigns - 1)] >> max_idx) & 1;
+			bool b1 = (signs[(symbol - nDelay) & (nSigns - 1)] >> max_idx) & 1;
 
-			FLOAT32 b = b1 ^ b2 ? 1.0f : -1.0f;
+			symbol = (symbol + 1) & (nSigns - 1);
 
-			Send(&b, 1, tag);
+			output[i] = b1 ^ b2 ? 1.0f : -1.0f;
 		}
+
+		Send(output.data(), len, tag);
 	}
 
 	void PhaseSearch::Receive(const CFLOAT32* data, int len, TAG& tag) {
+		if (output.size() < len) output.resize(len);
+
+		FLOAT32 avg[nPhases];
+
 		for (int i = 0; i < len; i++) {
 			FLOAT32 re = 0, im = 0;
 
-			//  multiply samples with (1j) ** i, to get all points on the same line
-			switch (rot) {
-			case 0:
-				re = data[i].real();
-				im = data[i].imag();
-				break;
-			case 1:
-				im = data[i].real();
-				re = -data[i].imag();
-				break;
-			case 2:
-				re = -data[i].real();
-				im = -data[i].imag();
-				break;
-			case 3:
-				im = -data[i].real();
-				re = data[i].imag();
-				break;
-			}
-
+			Rotate(data[i], rot, re, im);
 			rot = (rot + 1) & 3;
 
 			// Determining the phase is approached as a linear classification problem.
-			for (int j = 0; j < nPhases / 2; j++) {
-				FLOAT32 a = re * phase[j].real();
-				FLOAT32 b = im * phase[j].imag();
-				FLOAT32 t;
+			signs[symbol] = Project(re, im, memory[last]);
+
+			if (++last == nHistory) last = 0;
 
-				t = a + b;
-				bits[j] = (bits[j] << 1) | (t > 0);
-				memory[j][last] = std::abs(t);
+			// sum of the history for all phases, in the same order for each phase as a scalar loop
+#if defined(SIMD_SSE2) || defined(SIMD_NEON)
+			f32x4 s0 = simd_load(memory[0]), s1 = simd_load(memory[0] + 4);
+			f32x4 s2 = simd_load(memory[0] + 8), s3 = simd_load(memory[0] + 12);
 
-				t = a - b;
-				bits[nPhases - 1 - j] = (bits[nPhases - 1 - j] << 1) | (t > 0);
-				memory[nPhases - 1 - j][last] = std::abs(t);
+			for (int l = 1; l < nHistory; l++) {
+				s0 = simd_add(s0, simd_load(memory[l]));
+				s1 = simd_add(s1, simd_load(memory[l] + 4));
+				s2 = simd_add(s2, simd_load(memory[l] + 8));
+				s3 = simd_add(s3, simd_load(memory[l] + 12));
 			}
 
-			last = (last + 1) % nHistory;
+			simd_store(avg, s0);
+			simd_store(avg + 4, s1);
+			simd_store(avg + 8, s2);
+			simd_store(avg + 12, s3);
+#else
+			for (int j = 0; j < nPhases; j++) {
+				avg[j] = memory[0][j];
+				for (int l = 1; l < nHistory; l++) avg[j] += memory[l][j];
+			}
+#endif
 
 			FLOAT32 max_val = 0;
 			int prev_max = max_idx;
@@ -153,23 +236,22 @@ namespace Demod {
 			// local minmax search
 			for (int p = nPhases + prev_max - nSearch; p <= nPhases + prev_max + nSearch; p++) {
 				int j = p % nPhases;
-				FLOAT32 avg = memory[j][0];
-
-				for (int l = 1; l < nHistory; l++) avg += memory[j][l];
 
-				if (avg > max_val) {
-					max_val = avg;
+				if (avg[j] > max_val) {
+					max_val = avg[j];
 					max_idx = j;
 				}
 			}
 
 			// determine the bit
-			bool b2 = (bits[max_idx] >> (nDelay + 1)) & 1;
-			bool b1 = (bits[max_idx] >> nDelay) & 1;
+			bool b2 = (signs[(symbol - nDelay - 1) & (nSigns - 1)] >> max_idx) & 1;
+			bool b1 = (signs[(symbol - nDelay) & (nSigns - 1)] >> max_idx) & 1;
 
-			FLOAT32 b = b1 ^ b2 ? 1.0f : -1.0f;
+			symbol = (symbol + 1) & (nSigns - 1);
 
-			Send(&b, 1, tag);
+			output[i] = b1 ^ b2 ? 1.0f : -1.0f;
 		}
+
+		Send(output.data(), len, tag);
 	}
 }
@@ -26,6 +26,9 @@ namespace Demod {
 	// needs to be a power of two for the Fast version
 	static const int nPhases = 16;
 
+	// symbols of sign history kept by the phase searches, the delayed bit needs nDelay + 1 < nSigns
+	static const int nSigns = 8;
+
 	static const CFLOAT32 phase[nPhases / 2] = {
 		{ 9.9518472640441780e-01f, 9.8017143048367339e-02f }, { 9.5694033335306883e-01f, 2.9028468509743588e-01f }, { 8.8192125790916542e-01f, 4.7139674887287397e-01f }, { 7.7301044123076901e-01f, 6.3439329894649099e-01f }, { 6.3439326515712957e-01f, 7.7301046896098113e-01f }, { 4.7139671032286945e-01f, 8.8192127851457169e-01f }, { 2.9028464326824349e-01f, 9.5694034604181499e-01f }, { 9.8017099547459546e-02f, 9.9518473068888236e-01f }
 	};
@@ -45,12 +48,17 @@ namespace Demod {
 		static const int maxHistory = 14;
 		static const int nSearch = 2;
 
-		FLOAT32 memory[nPhases][maxHistory];
-		char bits[nPhases];
+		// |projection| on all phases per history slot, a row per symbol so phases are contiguous
+		FLOAT32 memory[maxHistory][nPhases] = { { 0 } };
+		// bit j is the sign of the projection on phase j, last nSigns symbols
+		uint16_t signs[nSigns] = { 0 };
+
+		std::vector<FLOAT32> output;
 
 		int max_idx = 0;
 		int rot = 0;
 		int last = 0;
+		int symbol = 0;
 
 	public:
 		virtual ~PhaseSearch() {}
@@ -60,6 +68,7 @@ namespace Demod {
 		void setParams(int h, int d) {
 			assert(nHistory <= maxHistory);
 			assert(nDelay <= nHistory);
+			assert(d + 1 < nSigns);
 			nHistory = h;
 			nDelay = d;
 		}
@@ -73,15 +82,21 @@ namespace Demod {
 		FLOAT32 weight = 0.85f;
 
 		FLOAT32 ma[nPhases] = { 0 };
-		char bits[nPhases] = { 0 };
+		uint16_t signs[nSigns] = { 0 };
+
+		std::vector<FLOAT32> output;
 
 		int max_idx = 0, rot = 0;
+		int symbol = 0;
 
 	public:
 		virtual ~PhaseSearchEMA() {}
 
 		void Receive(const CFLOAT32* data, int len, TAG& tag);
-		void setParams(int d) { nDelay = d; }
+		void setParams(int d) {
+			assert(d + 1 < nSigns);
+			nDelay = d;
+		}
 		void setWeight(FLOAT32 w) { weight = w; }
 	};
 }
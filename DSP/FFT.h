@@ -23,13 +23,13 @@
 #include "Common.h"
 
 namespace FFT {
-	static int log2(int x) {
+	static inline int log2(int x) {
 		int y = 0;
 		while (x >>= 1) y++;
 		return y;
 	}
 
-	static int rev(int x, int logN) {
+	static inline int rev(int x, int logN) {
 		static const int rev4[] = { 0, 8, 4, 12, 2, 10, 6, 14, 1, 9, 5, 13, 3, 11, 7, 15 };
 
 		int y = 0, j;
@@ -51,51 +51,79 @@ namespace FFT {
 		return y;
 	}
 
+	// FFT plan for a fixed size N (power of 2): bit-reversal table and the twiddle factors laid out per stage
+	// in the order the butterflies use them. Each user owns its plan so transforms on different threads share nothing.
 	template <typename T>
-	static void calcOmega(std::vector<std::complex<T>>& Omega, int N) {
-		Omega.resize(N);
+	class Plan {
+		int N = 0, logN = 0;
+		std::vector<int> bitrev;
+		std::vector<std::complex<T>> twiddles;
+
+	public:
+		void init(int n) {
+			N = n;
+			logN = log2(N);
 
-		for (int s = 0; s < N; s++)
-			Omega[s] = std::polar(T(1), T(-2.0 * PI) * T(s) / T(N));
-	}
+			bitrev.resize(N);
+			for (int i = 0; i < N; i++) bitrev[i] = FFT::rev(i, logN);
 
+			// per radix-4 stage: for each j the twiddles of the two radix-2 stages it replaces
+			const double pi = 3.14159265358979323846;
 
-	// Radix-2 FFT, standard algorithm with inner loops reversed and twiddle factors pre-computed
-	template <typename T>
-	void fft(std::vector<std::complex<T>>& x) {
-		std::complex<T> t;
+			twiddles.clear();
+			for (int m = (logN & 1) ? 2 : 1; 4 * m <= N; m *= 4) {
+				for (int j = 0; j < m; j++) {
+					twiddles.push_back(std::complex<T>(std::polar(1.0, -2.0 * pi * j / (2 * m))));
+					twiddles.push_back(std::complex<T>(std::polar(1.0, -2.0 * pi * j / (4 * m))));
+				}
+			}
+		}
 
-		static std::vector<std::complex<T>> Omega;
-		static int N = 0, logN;
+		int size() const { return N; }
 
-		if (N != x.size()) {
-			N = (int)x.size();
-			logN = log2(N);
-			calcOmega(Omega, N);
-		}
+		// position of sample i in the (bit-reversed) input of execute
+		int rev(int i) const { return bitrev[i]; }
 
-		int m = 2, m2 = 1;
-		int w, r = N;
+		// in-place forward FFT of bit-reversed input: a radix-2 stage if log2(N) is odd, followed by radix-4 stages
+		void execute(std::complex<T>* x) const {
+			int m = 1;
 
-		for (int s = 0; s < logN; s++) {
-			w = 0;
-			r >>= 1;
+			if (logN & 1) {
+				for (int k = 0; k < N; k += 2) {
+					std::complex<T> a = x[k], b = x[k + 1];
+					x[k] = a + b;
+					x[k + 1] = a - b;
+				}
+				m = 2;
+			}
 
-			for (int j = 0; j < m2; j++) {
-				const std::complex<T>& o = Omega[w];
+			const std::complex<T>* w = twiddles.data();
 
-				for (int k = 0; k < N; k += m) {
-					t = o * x[k + j + m2];
+			for (; 4 * m <= N; m *= 4) {
+				for (int k = 0; k < N; k += 4 * m) {
+					std::complex<T>* p = x + k;
 
-					x[k + j + m2] = x[k + j] - t;
-					x[k + j] += t;
-				}
+					for (int j = 0; j < m; j++) {
+						const std::complex<T> w1 = w[2 * j], w2 = w[2 * j + 1];
 
-				w += r;
-			}
+						std::complex<T> b = w1 * p[j + m], d = w1 * p[j + 3 * m];
+						std::complex<T> a1 = p[j] + b, b1 = p[j] - b;
+						std::complex<T> c1 = p[j + 2 * m] + d, d1 = p[j + 2 * m] - d;
+
+						c1 *= w2;
+						d1 *= w2;
+						d1 = std::complex<T>(d1.imag(), -d1.real());
 
-			m2 = m;
-			m <<= 1;
+						p[j] = a1 + c1;
+						p[j + 2 * m] = a1 - c1;
+						p[j + m] = b1 + d1;
+						p[j + 3 * m] = b1 - d1;
+					}
+				}
+				w += 2 * m;
+			}
 		}
-	}
+
+		void execute(std::vector<std::complex<T>>& x) const { execute(x.data()); }
+	};
 }
@@ -24,6 +24,7 @@ namespace AIS
 {
 	std::mutex MessageMutex::mtx;
 	std::mutex MessageMutexADSB::mtx;
+	std::mutex MessageMutexGPS::mtx;
 
 	void ModelFrontend::buildModel(char CH1, char CH2, int sample_rate, bool timerOn, Device::Device *dev)
 	{
@@ -125,6 +126,11 @@ namespace AIS
 			DS_MA.setRates(sample_rate, 96000);
 			physical >> convert >> DS_MA >> ROT;
 		}
+		else if (POLY_DS)
+		{
+			RS.setParams(sample_rate, 96000);
+			physical >> convert >> RS >> ROT;
+		}
 		else
 		{
 			const std::vector<uint32_t> definedRatesNoDSK = {96000, 192000, 288000, 384000, 768000, 1536000, 3072000, 6144000, 12288000};
@@ -152,6 +158,12 @@ namespace AIS
 
 			physical >> convert;
 
+			// fixed point downsampling works directly on 8-bit samples
+			bool fixedpoint = fixedpointDS && (device->getFormat() == Format::CU8 || device->getFormat() == Format::CS8);
+
+			if (fixedpointDS && !fixedpoint)
+				Warning() << "Model: fixed point downsampling requires CU8 or CS8 input, using floating point.";
+
 			// FDC is a 3-tap filter to compensate for droop in the CIC5 downsampling filters
 			// Filter coefficients currently set on empirical basis, and ignored for downsampling including decimation by 3
 
@@ -192,10 +204,20 @@ namespace AIS
 				// 2^5
 			case 3072000:
 				FDC.setTaps(-1.5f);
-				if (!droop_compensation)
-					convert >> DS2_5 >> DS2_4 >> DS2_3 >> DS2_2 >> DS2_1 >> ROT;
+				if (!fixedpoint)
+				{
+					if (!droop_compensation)
+						convert >> DS2_5 >> DS2_4 >> DS2_3 >> DS2_2 >> DS2_1 >> ROT;
+					else
+						convert >> DS2_5 >> DS2_4 >> DS2_3 >> DS2_2 >> DS2_1 >> FDC >> ROT;
+				}
 				else
-					convert >> DS2_5 >> DS2_4 >> DS2_3 >> DS2_2 >> DS2_1 >> FDC >> ROT;
+				{
+					if (!droop_compensation)
+						connectFixedPoint(32) >> ROT;
+					else
+						connectFixedPoint(32) >> FDC >> ROT;
+				}
 				break;
 			case 3072000 - 1:
 				FDC.setTaps(-1.5f);
@@ -222,7 +244,7 @@ namespace AIS
 				// 2^4
 			case 1536000:
 				FDC.setTaps(-1.2f);
-				if (!fixedpointDS)
+				if (!fixedpoint)
 				{
 					if (!droop_compensation)
 						convert >> DS2_4 >> DS2_3 >> DS2_2 >> DS2_1 >> ROT;
@@ -232,9 +254,9 @@ namespace AIS
 				else
 				{
 					if (!droop_compensation)
-						convert.outCU8 >> DS16_CU8 >> ROT;
+						connectFixedPoint(16) >> ROT;
 					else
-						convert.outCU8 >> DS16_CU8 >> FDC >> ROT;
+						connectFixedPoint(16) >> FDC >> ROT;
 				}
 				break;
 			case 1536000 - 1:
@@ -262,10 +284,20 @@ namespace AIS
 				// 2^3
 			case 768000:
 				FDC.setTaps(-1.2f);
-				if (!droop_compensation)
-					convert >> DS2_3 >> DS2_2 >> DS2_1 >> ROT;
+				if (!fixedpoint)
+				{
+					if (!droop_compensation)
+						convert >> DS2_3 >> DS2_2 >> DS2_1 >> ROT;
+					else
+						convert >> DS2_3 >> DS2_2 >> DS2_1 >> FDC >> ROT;
+				}
 				else
-					convert >> DS2_3 >> DS2_2 >> DS2_1 >> FDC >> ROT;
+				{
+					if (!droop_compensation)
+						connectFixedPoint(8) >> ROT;
+					else
+						connectFixedPoint(8) >> FDC >> ROT;
+				}
 				break;
 			case 768000 - 1:
 				FDC.setTaps(-1.2f);
@@ -339,8 +371,19 @@ namespace AIS
 			}
 		}
 
-		ROT.up >> DS2_a >> FCIC5_a;
-		ROT.down >> DS2_b >> FCIC5_b;
+		if (threaded)
+		{
+			ROT.up >> TH_a >> DS2_a >> FCIC5_a;
+			ROT.down >> TH_b >> DS2_b >> FCIC5_b;
+
+			TH_a.Start();
+			TH_b.Start();
+		}
+		else
+		{
+			ROT.up >> DS2_a >> FCIC5_a;
+			ROT.down >> DS2_b >> FCIC5_b;
+		}
 
 		// pick up point for downstream decoders
 		C_a = &FCIC5_a.out;
@@ -356,6 +399,36 @@ namespace AIS
 		return;
 	}
 
+	// fixed point CIC5 downsampling by 8, 16 or 32 straight from the CU8/CS8 device samples
+	StreamOut<CFLOAT32> &ModelFrontend::connectFixedPoint(int factor)
+	{
+		bool cu8 = device->getFormat() == Format::CU8;
+
+		switch (factor)
+		{
+		case 8:
+			if (cu8)
+				return convert.outCU8 >> DS8_CU8;
+			return convert.outCS8 >> DS8_CS8;
+		case 16:
+			if (cu8)
+				return convert.outCU8 >> DS16_CU8;
+			return convert.outCS8 >> DS16_CS8;
+		case 32:
+			if (cu8)
+				return convert.outCU8 >> DS32_CU8;
+			return convert.outCS8 >> DS32_CS8;
+		default:
+			throw std::runtime_error("Model: internal error. Unsupported fixed point downsampling factor.");
+		}
+	}
+
+	void ModelFrontend::Stop()
+	{
+		TH_a.Stop();
+		TH_b.Stop();
+	}
+
 	Setting &ModelFrontend::Set(std::string option, std::string arg)
 	{
 		Util::Convert::toUpper(option);
@@ -365,24 +438,35 @@ namespace AIS
 		{
 			fixedpointDS = Util::Parse::Switch(arg);
 			MA_DS = false;
+			POLY_DS = false;
 		}
 		else if (option == "SOXR")
 		{
 			SOXR_DS = Util::Parse::Switch(arg);
 			SAMPLERATE_DS = false;
 			MA_DS = false;
+			POLY_DS = false;
 		}
 		else if (option == "SRC")
 		{
 			SAMPLERATE_DS = Util::Parse::Switch(arg);
 			SOXR_DS = false;
 			MA_DS = false;
+			POLY_DS = false;
 		}
 		else if (option == "MA")
 		{
 			MA_DS = Util::Parse::Switch(arg);
 			SAMPLERATE_DS = false;
 			SOXR_DS = false;
+			POLY_DS = false;
+		}
+		else if (option == "POLYPHASE")
+		{
+			POLY_DS = Util::Parse::Switch(arg);
+			SAMPLERATE_DS = false;
+			SOXR_DS = false;
+			MA_DS = false;
 		}
 		else if (option == "DSK")
 		{
@@ -392,6 +476,10 @@ namespace AIS
 		{
 			droop_compensation = Util::Parse::Switch(arg);
 		}
+		else if (option == "THREADED")
+		{
+			threaded = Util::Parse::Switch(arg);
+		}
 		else if (option == "STATION_ID")
 		{
 			station = Util::Parse::Integer(arg);
@@ -421,8 +509,10 @@ namespace AIS
 			return "src ON " + Model::Get();
 		else if (MA_DS)
 			return "MA ON " + Model::Get();
+		else if (POLY_DS)
+			return "polyphase ON " + Model::Get();
 
-		return "droop " + Util::Convert::toString(droop_compensation) + " fp_ds " + Util::Convert::toString(fixedpointDS) + " dsk " + Util::Convert::toString(allowDSK) + " " + Model::Get();
+		return "droop " + Util::Convert::toString(droop_compensation) + " fp_ds " + Util::Convert::toString(fixedpointDS) + " dsk " + Util::Convert::toString(allowDSK) + " threaded " + Util::Convert::toString(threaded) + " " + Model::Get();
 	}
 
 	void ModelBase::buildModel(char CH1, char CH2, int sample_rate, bool timerOn, Device::Device *dev)
@@ -501,6 +591,10 @@ namespace AIS
 		S_a.setConnections(nSymbolsPerSample);
 		S_b.setConnections(nSymbolsPerSample);
 
+		// phase search and decoders take all symbols of a phase per block
+		S_a.setBlocks(true);
+		S_b.setBlocks(true);
+
 		DEC_a.resize(nSymbolsPerSample);
 		DEC_b.resize(nSymbolsPerSample);
 
@@ -527,26 +621,32 @@ namespace AIS
 		*C_a >> CGF_a >> FC_a >> S_a;
 		*C_b >> CGF_b >> FC_b >> S_b;
 
+		dedup_a >> output;
+		dedup_b >> output;
+
 		for (int i = 0; i < nSymbolsPerSample; i++)
 		{
 			DEC_a[i].setOrigin(CH1, station, own_mmsi);
 			DEC_b[i].setOrigin(CH2, station, own_mmsi);
 
+			group_a.add(DEC_a[i]);
+			group_b.add(DEC_b[i]);
+
 			if (!PS_EMA)
 			{
 				CD_a[i].setParams(nHistory, nDelay);
 				CD_b[i].setParams(nHistory, nDelay);
 
-				S_a.out[i] >> CD_a[i] >> DEC_a[i] >> output;
-				S_b.out[i] >> CD_b[i] >> DEC_b[i] >> output;
+				S_a.out[i] >> CD_a[i] >> DEC_a[i] >> dedup_a;
+				S_b.out[i] >> CD_b[i] >> DEC_b[i] >> dedup_b;
 			}
 			else
 			{
 				CD_EMA_a[i].setParams(nDelay);
 				CD_EMA_b[i].setParams(nDelay);
 
-				S_a.out[i] >> CD_EMA_a[i] >> DEC_a[i] >> output;
-				S_b.out[i] >> CD_EMA_b[i] >> DEC_b[i] >> output;
+				S_a.out[i] >> CD_EMA_a[i] >> DEC_a[i] >> dedup_a;
+				S_b.out[i] >> CD_EMA_b[i] >> DEC_b[i] >> dedup_b;
 			}
 			for (int j = 0; j < nSymbolsPerSample; j++)
 			{
@@ -634,6 +734,9 @@ namespace AIS
 		throttle_a.out[0] >> FM_af >> FR_af >> S_af;
 		throttle_b.out[0] >> FM_bf >> FR_bf >> S_bf;
 
+		dedup_a >> output;
+		dedup_b >> output;
+
 		for (int i = 0; i < nSymbolsPerSample; i++)
 		{
 			DEC_a[i].setOrigin(CH1, station, own_mmsi);
@@ -645,11 +748,11 @@ namespace AIS
 			CD_EMA_a[i].setParams(nDelay);
 			CD_EMA_b[i].setParams(nDelay);
 
-			S_a.out[i] >> CD_EMA_a[i] >> DEC_a[i] >> output;
-			S_b.out[i] >> CD_EMA_b[i] >> DEC_b[i] >> output;
+			S_a.out[i] >> CD_EMA_a[i] >> DEC_a[i] >> dedup_a;
+			S_b.out[i] >> CD_EMA_b[i] >> DEC_b[i] >> dedup_b;
 
-			S_af.out[i] >> DEC_af[i] >> output;
-			S_bf.out[i] >> DEC_bf[i] >> output;
+			S_af.out[i] >> DEC_af[i] >> dedup_a;
+			S_bf.out[i] >> DEC_bf[i] >> dedup_b;
 
 			for (int j = 0; j < nSymbolsPerSample; j++)
 			{
@@ -759,11 +862,32 @@ namespace AIS
 	{
 		setName("NMEA input");
 		device = dev;
-		*device >> nmea >> output;
-		nmea.outGPS >> output_gps;
 
 		nmea.setStation(station);
 		nmea.setOwnMMSI(own_mmsi);
+
+		if (threads > 1)
+		{
+			workers.setup(nmea, threads);
+			*device >> workers;
+
+			for (int i = 0; i < workers.size(); i++)
+			{
+				workers[i] >> output;
+				workers[i].outGPS >> output_gps;
+			}
+			workers.Start();
+		}
+		else
+		{
+			*device >> nmea >> output;
+			nmea.outGPS >> output_gps;
+		}
+	}
+
+	void ModelNMEA::Stop()
+	{
+		workers.Stop();
 	}
 
 	Setting &ModelNMEA::Set(std::string option, std::string arg)
@@ -799,6 +923,10 @@ namespace AIS
 		{
 			nmea.setGPS(Util::Parse::Switch(arg));
 		}
+		else if (option == "THREADS")
+		{
+			threads = Util::Parse::Integer(arg, 0, 64, option);
+		}
 		else
 			Model::Set(option, arg);
 
@@ -807,7 +935,7 @@ namespace AIS
 
 	std::string ModelNMEA::Get()
 	{
-		return "nmea_refresh " + Util::Convert::toString(nmea.getRegenerate()) + " uuid " + nmea.getUUID() + " ID " + std::to_string(nmea.getStation()) + " stamp " + Util::Convert::toString(nmea.getStamp()) + " crc_check " + Util::Convert::toString(nmea.getCRCcheck()) + " VDO " + Util::Convert::toString(nmea.getVDO()) + Model::Get();
+		return "nmea_refresh " + Util::Convert::toString(nmea.getRegenerate()) + " uuid " + nmea.getUUID() + " ID " + std::to_string(nmea.getStation()) + " stamp " + Util::Convert::toString(nmea.getStamp()) + " crc_check " + Util::Convert::toString(nmea.getCRCcheck()) + " VDO " + Util::Convert::toString(nmea.getVDO()) + " threads " + std::to_string(threads) + Model::Get();
 	}
 
 	void ModelN2K::buildModel(char CH1, char CH2, int sample_rate, bool timerOn, Device::Device *dev)
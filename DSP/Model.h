@@ -91,6 +91,25 @@ namespace AIS
 		}
 	};
 
+	// same for GPS positions, which can also come from several NMEA worker threads
+	class MessageMutexGPS : public SimpleStreamInOut<GPS, GPS>
+	{
+		static std::mutex mtx;
+
+	public:
+		virtual ~MessageMutexGPS() {}
+		virtual void Receive(const GPS *data, int len, TAG &tag)
+		{
+			std::lock_guard<std::mutex> lock(mtx);
+			Send(data, len, tag);
+		}
+		virtual void Receive(GPS *data, int len, TAG &tag)
+		{
+			std::lock_guard<std::mutex> lock(mtx);
+			Send(data, len, tag);
+		}
+	};
+
 	// Abstract demodulation model
 	class Model : public Setting
 	{
@@ -106,11 +125,12 @@ namespace AIS
 		Util::Timer<RAW> timer;
 		MessageMutex output;
 		MessageMutexADSB outputADSB;
-		Util::PassThrough<GPS> output_gps;
+		MessageMutexGPS output_gps;
 
 	public:
 		virtual ~Model() {}
 		virtual void buildModel(char, char, int, bool, Device::Device *d) { device = d; }
+		virtual void Stop() {}
 
 		StreamOut<Message> &Output() { return output; }
 		StreamOut<GPS> &OutputGPS() { return output_gps; }
@@ -148,6 +168,7 @@ namespace AIS
 	private:
 		DSP::SOXR sox;
 		DSP::SRC src;
+		DSP::Resample RS;
 		DSP::DownsampleKFilter DSK;
 		DSP::Downsample2CIC5 DS2_1, DS2_2, DS2_3, DS2_4, DS2_5, DS2_6, DS2_7;
 		DSP::Downsample2CIC5 DS2_a, DS2_b;
@@ -156,16 +177,24 @@ namespace AIS
 		DSP::FilterComplex3Tap FDC;
 		DSP::DownsampleMovingAverage DS_MA;
 		// fixed point downsamplers
+		DSP::Downsample8_CU8 DS8_CU8;
+		DSP::Downsample8_CS8 DS8_CS8;
 		DSP::Downsample16_CU8 DS16_CU8;
+		DSP::Downsample16_CS8 DS16_CS8;
+		DSP::Downsample32_CU8 DS32_CU8;
+		DSP::Downsample32_CS8 DS32_CS8;
 
 		Util::ConvertRAW convert;
 
+		StreamOut<CFLOAT32> &connectFixedPoint(int factor);
+
 	protected:
 		bool fixedpointDS = false;
 		bool droop_compensation = true;
 		bool SOXR_DS = false;
 		bool SAMPLERATE_DS = false;
 		bool MA_DS = false;
+		bool POLY_DS = false;
 		bool allowDSK = false;
 
 		const int nSymbolsPerSample = 48000 / 9600;
@@ -173,6 +202,10 @@ namespace AIS
 		Connection<CFLOAT32> *C_a = nullptr, *C_b = nullptr;
 		DSP::Rotate ROT;
 
+		// optional worker thread per channel after the +/- 25K split
+		StreamThread<CFLOAT32> TH_a, TH_b;
+		bool threaded = false;
+
 		// dump 48K channels to WAV files
 		Util::WriteWAV wavA, wavB;
 		Util::ConvertToRAW convertA, convertB;
@@ -180,6 +213,7 @@ namespace AIS
 
 	public:
 		void buildModel(char, char, int, bool, Device::Device *);
+		void Stop();
 
 		Setting &Set(std::string option, std::string arg);
 		std::string Get();
@@ -219,6 +253,8 @@ namespace AIS
 
 		DSP::FilterComplex FC_a, FC_b;
 		std::vector<AIS::Decoder> DEC_a, DEC_b;
+		AIS::DecoderGroup group_a, group_b;
+		AIS::DecoderDedup dedup_a, dedup_b;
 		DSP::ScatterPLL S_a, S_b;
 
 	protected:
@@ -246,6 +282,7 @@ namespace AIS
 		Demod::FM FM_af, FM_bf;
 
 		std::vector<AIS::Decoder> DEC_a, DEC_b, DEC_af, DEC_bf;
+		AIS::DecoderDedup dedup_a, dedup_b;
 		DSP::ScatterPLL S_a, S_b;
 
 		DSP::Deinterleave<CFLOAT32> throttle_a, throttle_b;
@@ -287,8 +324,13 @@ namespace AIS
 	{
 		NMEA nmea;
 
+		// optional worker threads, input is sharded by sender address
+		NMEAWorkers workers;
+		int threads = 0;
+
 	public:
 		void buildModel(char, char, int, bool, Device::Device *);
+		void Stop();
 		Setting &Set(std::string option, std::string arg);
 		std::string Get();
 		ModelClass getClass() { return ModelClass::TXT; }
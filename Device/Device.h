@@ -137,6 +137,9 @@ namespace Device {
 		virtual std::string getSerial() {
 			return "";
 		}
+		virtual std::string getBufferStatus() {
+			return "";
+		}
 
 		virtual void setFormat(Format f) { format = f; }
 		virtual Format getFormat() { return format; }
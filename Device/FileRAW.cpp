@@ -35,10 +35,15 @@ namespace Device
 
 				if (!file->eof())
 				{
-					file->read((char *)buffer.data(), buffer.size());
-					std::streamsize bytesRead = file->gcount();
-					if (bytesRead > 0)
-						fifo.Push(buffer.data(), bytesRead, true);
+					// read directly into the FIFO
+					int sz = fifo.BlockSize();
+					char *data = fifo.Lease(sz, true);
+
+					if (!data)
+						break;
+
+					file->read(data, sz);
+					fifo.Commit((int)file->gcount());
 				}
 				else
 				{
@@ -102,12 +107,10 @@ namespace Device
 		if (getFormat() != Format::TXT && getFormat() != Format::BASESTATION && getFormat() != Format::BEAST && getFormat() != Format::RAW1090)
 		{
 			fifo.Init(BUFFER_SIZE, BUFFER_COUNT);
-			buffer.resize(BUFFER_SIZE);
 		}
 		else
 		{
 			fifo.Init(TXT_BLOCK_SIZE, BUFFER_SIZE);
-			buffer.resize(TXT_BLOCK_SIZE);
 		}
 
 		if (filename == "." || filename == "stdin")
@@ -25,7 +25,6 @@ namespace Device {
 		std::istream* file = NULL;
 
 		std::string filename;
-		std::vector<char> buffer;
 
 		std::thread read_thread;
 		std::thread run_thread;
@@ -57,6 +56,7 @@ namespace Device {
 		Setting& Set(std::string option, std::string arg);
 		std::string Get();
 		std::string getProduct() { return "File (RAW)"; }
+		std::string getBufferStatus() { return fifo.getStatus(); }
 		std::string getVendor() { return "File"; }
 		std::string getSerial() { return filename; }
 	};
@@ -93,6 +93,7 @@ namespace Device {
 		std::string Get();
 
 		std::string getProduct() { return product; }
+		std::string getBufferStatus() { return fifo.getStatus(); }
 		std::string getVendor() { return vendor; }
 		std::string getSerial() { return serial; }
 
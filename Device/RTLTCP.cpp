@@ -116,8 +116,16 @@ namespace Device
 
 		while (isStreaming())
 		{
+			// read directly into the FIFO if a full transfer fits before the wrap, as message based
+			// protocols (e.g. MQTT) drop packets that do not fit, otherwise go via the local buffer
+			int sz = TRANSFER_SIZE;
+			char *data = fifo.TryLease(sz);
+			bool direct = data && sz == TRANSFER_SIZE;
 
-			int len = session->read(buffer.data(), TRANSFER_SIZE, 1);
+			if (!direct)
+				data = buffer.data();
+
+			int len = session->read(data, TRANSFER_SIZE, 1);
 
 			if (len < 0)
 			{
@@ -125,6 +133,8 @@ namespace Device
 				Error() << "RTLTCP: error receiving data from remote host. Cancelling. ";
 				break;
 			}
+			else if (direct)
+				fifo.Commit(len);
 			else if (isStreaming() && !fifo.Push(buffer.data(), len))
 				Error() << "RTLTCP: buffer overrun.";
 		}
@@ -132,7 +142,6 @@ namespace Device
 
 	void RTLTCP::Run()
 	{
-		std::vector<char> output(fifo.BlockSize());
 		RAW r = {getFormat(), NULL, fifo.BlockSize()};
 
 		while (isStreaming())
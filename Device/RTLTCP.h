@@ -82,6 +82,7 @@ namespace Device
 		std::string Get();
 
 		std::string getProduct() { return "RTLTCP"; }
+		std::string getBufferStatus() { return fifo.getStatus(); }
 		std::string getSerial() { return /*"P" + port*/ ""; }
 		std::string getVendor() { return "Network"; }
 	};
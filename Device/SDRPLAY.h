@@ -74,6 +74,7 @@ namespace Device {
 		~SDRPLAY();
 
 		std::string getProduct() { return getHardwareDescription(device.hwVer); }
+		std::string getBufferStatus() { return fifo.getStatus(); }
 		std::string getVendor() { return "SDRPLAY"; }
 		std::string getSerial() { return device.SerNo; }
 
@@ -96,6 +96,7 @@ namespace Device {
 		std::string Get();
 
 		std::string getProduct() { return "SOAPYSDR"; }
+		std::string getBufferStatus() { return fifo.getStatus(); }
 		void setFormat(Format f) {}
 #endif
 	};
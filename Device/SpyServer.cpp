@@ -235,7 +235,17 @@ namespace Device {
 			}
 
 			if (remainingBytes) {
-				int len = client.read(data.data(), remainingBytes, timeout, false);
+				// read directly into the FIFO, if full the data is read into the local buffer and dropped
+				int sz = remainingBytes;
+				char* ptr = fifo.Lease(sz);
+				bool overrun = !ptr;
+
+				if (overrun) {
+					ptr = data.data();
+					sz = MIN(remainingBytes, (int)data.size());
+				}
+
+				int len = client.read(ptr, sz, timeout, false);
 
 				if (len <= 0) {
 					Error() << "SPYSERVER: error receiving data from remote host. Cancelling. ";
@@ -243,7 +253,12 @@ namespace Device {
 					break;
 				}
 				else {
-					if (isStreaming() && !fifo.Push(data.data(), len)) Error() << "SPYSERVER: buffer overrun.";
+					if (overrun) {
+						if (isStreaming()) Error() << "SPYSERVER: buffer overrun.";
+					}
+					else
+						fifo.Commit(len);
+
 					remainingBytes -= len;
 				}
 			}
@@ -269,9 +284,12 @@ namespace Device {
 	void SpyServer::Run() {
 		while (isStreaming()) {
 			if (fifo.Wait()) {
-				RAW r = { getFormat(), fifo.Front(), fifo.BlockSize() };
+				int nblocks = -1;
+				RAW r = { getFormat(), fifo.Front(nblocks), 0 };
+				r.size = nblocks * fifo.BlockSize();
+
 				Send(&r, 1, tag);
-				fifo.Pop();
+				fifo.Pop(nblocks);
 			}
 			else {
 				if (isStreaming()) Error() << "SPYSERVER: timeout.";
@@ -239,6 +239,7 @@ namespace Device {
 		std::string Get();
 
 		std::string getProduct() { return "SPYSERVER"; }
+		std::string getBufferStatus() { return fifo.getStatus(); }
 		void setFormat(Format f) {}
 	};
 }
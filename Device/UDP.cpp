@@ -134,10 +134,16 @@ namespace Device
 			{
 				do
 				{
-					nread = recv(sock, buffer, sizeof(buffer), 0);
+					struct sockaddr_storage sender;
+					socklen_t sender_len = sizeof(sender);
+
+					nread = recvfrom(sock, buffer, sizeof(buffer), 0, (struct sockaddr *)&sender, &sender_len);
 
 					if (nread > 0)
 					{
+						// sender address, used to keep the input of each sender together downstream
+						tag.ipv4 = sender.ss_family == AF_INET ? ntohl(((struct sockaddr_in *)&sender)->sin_addr.s_addr) : 0;
+
 						r.size = nread;
 						Send(&r, 1, tag);
 					}
@@ -86,8 +86,6 @@ namespace Device {
 	}
 
 	void ZMQ::Run() {
-		std::vector<char> output(fifo.BlockSize());
-
 		while (isStreaming()) {
 			if (fifo.Wait()) {
 				RAW r = { getFormat(), fifo.Front(), fifo.BlockSize() };
@@ -65,6 +65,7 @@ namespace Device {
 		std::string Get();
 
 		std::string getProduct() { return "ZMQ"; }
+		std::string getBufferStatus() { return fifo.getStatus(); }
 #endif
 	};
 }
@@ -161,7 +161,7 @@ namespace IO
 			{
 				if (filter.include(data[i]))
 				{
-					for (const std::string &s : data[0].NMEA)
+					for (const auto &s : data[0].NMEA)
 					{
 						file << s << std::endl;
 					}
@@ -366,14 +366,8 @@ namespace IO {
 
 	void N2KStreamer::sendType14(const AIS::Message& ais, const JSON::JSON* data) {
 
-		std::string text;
-		for (const JSON::Property& p : data[0].getProperties()) {
-			switch (p.Key()) {
-			case AIS::KEY_TEXT: {
-				text = p.Get().getString();
-			} break;
-			}
-		}
+		const JSON::Value* v = data[0].getValue(AIS::KEY_TEXT);
+		std::string text = v ? v->getString() : "";
 
 		tN2kMsg N2kMsg;
 
@@ -20,6 +20,8 @@
 #include <vector>
 #include <iostream>
 #include <memory>
+#include <algorithm>
+#include <stdint.h>
 
 #include "Utilities.h"
 #include "Common.h"
@@ -52,7 +54,7 @@ namespace JSON
 			long int i;
 			double f;
 			std::string *s;
-			std::vector<std::string> *as;
+			const Util::Lines *as;
 			std::vector<Value> *a;
 			JSON *o;
 		} data;
@@ -61,9 +63,13 @@ namespace JSON
 		double getFloat(double d = 0.0f) const { return isFloat() ? data.f : (isInt() ? (double)(data.i) : d); }
 		long int getInt(long int d = 0) const { return isInt() ? data.i : d; }
 		bool getBool(bool d = false) const { return isBool() ? data.b : d; }
-		const std::vector<std::string> &getStringArray() const { return *data.as; }
+		const Util::Lines &getStringArray() const { return *data.as; }
 		const std::vector<Value> &getArray() const { return *data.a; }
-		const std::string getString() const { return isString() ? *data.s : std::string(""); }
+		const std::string &getString() const
+		{
+			static const std::string empty;
+			return isString() ? *data.s : empty;
+		}
 		const JSON &getObject() const { return *data.o; }
 
 		const bool isObject() const { return type == Type::OBJECT; }
@@ -96,7 +102,7 @@ namespace JSON
 			data.a = v;
 			type = Type::ARRAY;
 		}
-		void setStringArray(std::vector<std::string> *v)
+		void setStringArray(const Util::Lines *v)
 		{
 			data.as = v;
 			type = Type::ARRAY_STRING;
@@ -153,7 +159,7 @@ namespace JSON
 			key = p;
 			value.setString(v);
 		}
-		Property(int p, std::vector<std::string> *v)
+		Property(int p, const Util::Lines *v)
 		{
 			key = p;
 			value.setStringArray(v);
@@ -173,6 +179,38 @@ namespace JSON
 		const Value &Get() const { return value; }
 	};
 
+	// fills in the properties of an object on first access, e.g. AIS::JSONAIS decodes a message only when a consumer
+	// reads its fields. Consumers that only look at the binary message never trigger the decoding.
+	class Producer
+	{
+	public:
+		virtual ~Producer() {}
+		virtual void produce(JSON &json) = 0;
+	};
+
+	// items handed out by a pool stay allocated when the pool is rewound and are reused for the next document,
+	// a copy of a document shares the items, these are not reused while the copy holds on to them
+	template <typename T>
+	class Pool
+	{
+		std::vector<std::shared_ptr<T>> items;
+		int used = 0;
+
+	public:
+		T *next()
+		{
+			if (used == (int)items.size())
+				items.push_back(std::shared_ptr<T>(new T()));
+			else if (items[used].use_count() > 1)
+				items[used] = std::shared_ptr<T>(new T());
+
+			return items[used++].get();
+		}
+
+		void rewind() { used = 0; }
+		int size() const { return used; }
+	};
+
 	class JSON
 	{
 		friend class Parser;
@@ -180,28 +218,111 @@ namespace JSON
 	private:
 		std::vector<Property> properties;
 
+		// pending producer, cleared before it runs, only valid while the object is being sent downstream
+		mutable Producer *producer = nullptr;
+
+		void materialize() const
+		{
+			if (producer)
+			{
+				Producer *p = producer;
+				producer = nullptr;
+				// a lazy object is owned (non-const) by its producer
+				p->produce(const_cast<JSON &>(*this));
+			}
+		}
+
 		// memory to pointers containing objects, strings and arrays
 		// Property and Value can therefore only contain pointers and basic data types
-		std::vector<std::shared_ptr<JSON>> objects;
-		std::vector<std::shared_ptr<std::string>> strings;
-		std::vector<std::shared_ptr<std::vector<Value>>> arrays;
+		// clear() rewinds the pools so a document that is reused does not allocate once it has warmed up
+		Pool<JSON> objects;
+		Pool<std::string> strings;
+		Pool<std::vector<Value>> arrays;
+		std::vector<std::shared_ptr<JSON>> shared;
+
+		// key index next to properties: a bit per key that is set and the position of its (first) property,
+		// clear() only resets the bits, slots of keys that are not set are never read
+		std::vector<uint64_t> key_set;
+		std::vector<int> key_slot;
+
+		void addProperty(const Property &p)
+		{
+			int k = p.Key();
+
+			if (k >= 0)
+			{
+				if (k >= (int)key_slot.size())
+				{
+					key_slot.resize((k / 64 + 1) * 64);
+					key_set.resize(k / 64 + 1, 0);
+				}
+
+				uint64_t bit = (uint64_t)1 << (k & 63);
+				if (!(key_set[k >> 6] & bit))
+				{
+					key_set[k >> 6] |= bit;
+					key_slot[k] = (int)properties.size();
+				}
+			}
+			properties.push_back(p);
+		}
+
+		JSON *newObject()
+		{
+			JSON *o = objects.next();
+			o->clear();
+			return o;
+		}
+
+		std::string *newString(const std::string &v)
+		{
+			std::string *str = strings.next();
+			str->assign(v);
+			return str;
+		}
+
+		std::vector<Value> *newArray()
+		{
+			std::vector<Value> *a = arrays.next();
+			a->clear();
+			return a;
+		}
 
 	public:
 		void *binary = NULL;
 		
 		void clear()
 		{
+			producer = nullptr;
 			properties.clear();
+			std::fill(key_set.begin(), key_set.end(), 0);
 
-			objects.clear();
-			strings.clear();
-			arrays.clear();
+			objects.rewind();
+			strings.rewind();
+			arrays.rewind();
+			shared.clear();
 		}
 
-		const std::vector<Property> &getProperties() const { return properties; }
+		void setProducer(Producer *p) { producer = p; }
+		bool isLazy() const { return producer != nullptr; }
+
+		const std::vector<Property> &getProperties() const
+		{
+			materialize();
+			return properties;
+		}
 
 		const Value *getValue(int p) const
 		{
+			materialize();
+
+			if (p >= (int)key_slot.size())
+				return nullptr;
+
+			if (p >= 0)
+				return (key_set[p >> 6] >> (p & 63)) & 1 ? &properties[key_slot[p]].Get() : nullptr;
+
+			// unknown keys are not indexed
 			for (auto &o : properties)
 				if (o.Key() == p)
 					return &o.Get();
@@ -213,50 +334,49 @@ namespace JSON
 
 		void Add(int p, int v)
 		{
-			properties.push_back(Property(p, (long int)v));
+			addProperty(Property(p, (long int)v));
 		}
 
 		void Add(int p, double v)
 		{
-			properties.push_back(Property(p, (double)v));
+			addProperty(Property(p, (double)v));
 		}
 
 		void Add(int p, bool v)
 		{
-			properties.push_back(Property(p, (bool)v));
+			addProperty(Property(p, (bool)v));
 		}
 
 		void Add(int p, std::shared_ptr<JSON> &v)
 		{
-			objects.push_back(v);
-			properties.push_back(Property(p, (JSON *)v.get()));
+			shared.push_back(v);
+			addProperty(Property(p, (JSON *)v.get()));
 		}
 
 		void Add(int p, const std::string &v)
 		{
-			strings.push_back(std::shared_ptr<std::string>(new std::string(v)));
-			properties.push_back(Property(p, (std::string *)strings.back().get()));
+			addProperty(Property(p, newString(v)));
 		}
 
 		void Add(int p)
 		{
-			properties.push_back(Property(p));
+			addProperty(Property(p));
 		}
 
 		void Add(int p, Value v)
 		{
-			properties.push_back(Property(p, (Value)v));
+			addProperty(Property(p, (Value)v));
 		}
 
 		// for items where memory is managed outside the object
 		void Add(int p, const std::string *v)
 		{
-			properties.push_back(Property(p, (std::string *)v));
+			addProperty(Property(p, (std::string *)v));
 		}
 
-		void Add(int p, const std::vector<std::string> *v)
+		void Add(int p, const Util::Lines *v)
 		{
-			properties.push_back(Property(p, (std::vector<std::string> *)v));
+			addProperty(Property(p, v));
 		}
 	};
 }
@@ -16,6 +16,7 @@
 */
 
 #include <string>
+#include <cstring>
 #include <cmath>
 
 #include "Parser.h"
@@ -25,11 +26,21 @@ namespace JSON
 
 	// Parser -- Build JSON object from String
 
+	void Parser::buildKeys()
+	{
+		keys.clear();
+
+		// first entry wins, as in a linear search of the map
+		for (int i = 0; i < keymap->size(); i++)
+			if (dict < (*keymap)[i].size())
+				keys.emplace((*keymap)[i][dict], i);
+	}
+
 	void Parser::error(const std::string &err, int pos)
 	{
 		const int char_limit = 40;
 		int from = MAX(pos - char_limit, 0);
-		int to = MIN(pos + char_limit, json.size());
+		int to = MIN(pos + char_limit, size);
 
 		std::stringstream ss;
 		for (int i = from; i < to; i++)
@@ -44,197 +55,206 @@ namespace JSON
 		throw std::runtime_error("syntax error in JSON: " + err);
 	}
 
-	// Lex analysis
+	// Lex analysis, one token at a time
 
-	void Parser::skip_whitespace(int &ptr)
+	void Parser::skip_whitespace()
 	{
-		while (ptr < json.size() && std::isspace(json[ptr]))
+		while (ptr < size && std::isspace(json[ptr]))
 			ptr++;
 	}
 
-	void Parser::tokenizer()
+	void Parser::tokenize()
 	{
+		std::string &s = token.text;
 
-		tokens.clear();
-		std::string s;
-		int ptr = 0;
-
-		while (ptr < json.size())
+		skip_whitespace();
+		if (ptr == size)
 		{
+			token.type = TokenType::End;
+			token.pos = ptr;
+			return;
+		}
 
-			skip_whitespace(ptr);
-			if (ptr == json.size())
-				break;
-
-			char c = json[ptr];
+		char c = json[ptr];
 
-			// number
-			if (std::isdigit(c) || c == '-')
-			{
-				bool floating = false;
-				int start_idx = ptr;
-				bool scientific = false;
+		// number
+		if (std::isdigit(c) || c == '-')
+		{
+			bool floating = false;
+			int start_idx = ptr;
+			bool scientific = false;
 
-				s.clear();
+			s.clear();
 
-				do
+			do
+			{
+				if (json[ptr] == '.')
 				{
-					if (json[ptr] == '.')
-					{
-						if (floating || start_idx == ptr || !std::isdigit(json[ptr - 1]))
-							error("malformed number", ptr);
-						else
-							floating = true;
-					}
-					else if ((json[ptr] == 'e' || json[ptr] == 'E') && !scientific)
-					{
-						if (!std::isdigit(json[ptr - 1]) && json[ptr - 1] != '.')
-							error("malformed number", ptr);
+					if (floating || start_idx == ptr || !std::isdigit(json[ptr - 1]))
+						error("malformed number", ptr);
+					else
+						floating = true;
+				}
+				else if ((json[ptr] == 'e' || json[ptr] == 'E') && !scientific)
+				{
+					if (!std::isdigit(json[ptr - 1]) && json[ptr - 1] != '.')
+						error("malformed number", ptr);
 
-						scientific = floating = true;
+					scientific = floating = true;
 
+					s += json[ptr++];
+					if (ptr != size && (json[ptr] == '+' || json[ptr] == '-'))
+					{
 						s += json[ptr++];
-						if (ptr != json.size() && (json[ptr] == '+' || json[ptr] == '-'))
-						{
-							s += json[ptr++];
-						}
-
-						if (ptr == json.size() || !std::isdigit(json[ptr]))
-							error("malformed number", ptr);
 					}
 
-					s += json[ptr++];
-
-				} while (ptr != json.size() && (std::isdigit(json[ptr]) || json[ptr] == '.' || json[ptr] == 'e' || json[ptr] == 'E'));
+					if (ptr == size || !std::isdigit(json[ptr]))
+						error("malformed number", ptr);
+				}
 
-				tokens.push_back(Token(floating ? TokenType::FloatingPoint : TokenType::Integer, s, ptr));
-			}
-			// string
-			else if (c == '\"')
-			{
-				s.clear();
-				ptr++;
+				s += json[ptr++];
 
-				while (ptr != json.size() && json[ptr] != '\"' && json[ptr] != '\n' && json[ptr] != '\r')
-				{
-					char c = json[ptr];
-					if (c == '\\')
-					{
-						if (++ptr == json.size())
-							error("line ends in string literal escape sequence", ptr);
-						c = json[ptr];
-						switch (c)
-						{
-						case '\"':
-							break;
-						case '\\':
-							break;
-						case '/':
-							break;
-						case 'b':
-							c = '\b';
-							break;
-						case 'f':
-							c = '\f';
-							break;
-						case 'n':
-							c = '\n';
-							break;
-						case 'r':
-							c = '\r';
-							break;
-						case 't':
-							c = '\t';
-							break;
-						case 'u':
-						{
-							if (ptr + 4 >= json.size())
-								error("line ends in string literal unicode escape sequence", ptr);
-							std::string hex = json.substr(ptr + 1, 4);
-							for (int i = 0; i < 4; i++)
-								if (!std::isxdigit(hex[i]))
-									error("illegal unicode escape sequence", ptr);
-							c = std::stoi(hex, nullptr, 16);
-							ptr += 4;
-							break;
-						}
-						default:
-							error("illegal escape sequence " + std::to_string((int)(c)), ptr);
-						}
-					}
-					s += c;
-					ptr++;
-				};
+			} while (ptr != size && (std::isdigit(json[ptr]) || json[ptr] == '.' || json[ptr] == 'e' || json[ptr] == 'E'));
 
-				if (json.size() == ptr || json[ptr] != '\"')
-					error("line ends in string literal", ptr);
+			token.type = floating ? TokenType::FloatingPoint : TokenType::Integer;
+			token.pos = ptr;
+		}
+		// string
+		else if (c == '\"')
+		{
+			s.clear();
+			ptr++;
 
-				tokens.push_back(Token(TokenType::String, s, ptr));
-				ptr++;
-			}
-			// keyword
-			else if (isalpha(c))
+			while (ptr != size && json[ptr] != '\"' && json[ptr] != '\n' && json[ptr] != '\r')
 			{
+				// copy the run up to the next quote, escape or line end in one go
+				int start = ptr;
+				while (ptr != size && json[ptr] != '\"' && json[ptr] != '\\' && json[ptr] != '\n' && json[ptr] != '\r')
+					ptr++;
+				s.append(json + start, ptr - start);
 
-				s.clear();
-
-				while (ptr != json.size() && isalpha(json[ptr]))
-					s += json[ptr++];
+				if (ptr == size || json[ptr] != '\\')
+					break;
 
-				if (s == "true")
-					tokens.push_back(Token(TokenType::True, "", ptr));
-				else if (s == "false")
-					tokens.push_back(Token(TokenType::False, "", ptr));
-				else if (s == "null")
-					tokens.push_back(Token(TokenType::Null, "", ptr));
-				else
-					error("illegal identifier : \"" + s + "\"", ptr);
-			}
-			// special characters
-			else
-			{
+				if (++ptr == size)
+					error("line ends in string literal escape sequence", ptr);
+				char c = json[ptr];
 				switch (c)
 				{
-				case '{':
-					tokens.push_back(Token(TokenType::LeftBrace, "", ptr));
+				case '\"':
 					break;
-				case '}':
-					tokens.push_back(Token(TokenType::RightBrace, "", ptr));
+				case '\\':
 					break;
-				case '[':
-					tokens.push_back(Token(TokenType::LeftBracket, "", ptr));
+				case '/':
 					break;
-				case ']':
-					tokens.push_back(Token(TokenType::RightBracket, "", ptr));
+				case 'b':
+					c = '\b';
 					break;
-				case ':':
-					tokens.push_back(Token(TokenType::Colon, "", ptr));
+				case 'f':
+					c = '\f';
 					break;
-				case ',':
-					tokens.push_back(Token(TokenType::Comma, "", ptr));
+				case 'n':
+					c = '\n';
 					break;
-				default:
-					error("illegal character '" + std::string(1, c) + "'", ptr);
+				case 'r':
+					c = '\r';
+					break;
+				case 't':
+					c = '\t';
+					break;
+				case 'u':
+				{
+					if (ptr + 4 >= size)
+						error("line ends in string literal unicode escape sequence", ptr);
+					int code = 0;
+					for (int i = 1; i <= 4; i++)
+					{
+						char h = json[ptr + i];
+						if (!std::isxdigit(h))
+							error("illegal unicode escape sequence", ptr);
+						code = code * 16 + (std::isdigit(h) ? h - '0' : (std::tolower(h) - 'a' + 10));
+					}
+					c = code;
+					ptr += 4;
 					break;
 				}
+				default:
+					error("illegal escape sequence " + std::to_string((int)(c)), ptr);
+				}
+				s += c;
 				ptr++;
+			};
+
+			if (size == ptr || json[ptr] != '\"')
+				error("line ends in string literal", ptr);
+
+			token.type = TokenType::String;
+			token.pos = ptr;
+			ptr++;
+		}
+		// keyword
+		else if (isalpha(c))
+		{
+			int start = ptr;
+
+			while (ptr != size && isalpha(json[ptr]))
+				ptr++;
+
+			int len = ptr - start;
+
+			if (len == 4 && !std::strncmp(json + start, "true", 4))
+				token.type = TokenType::True;
+			else if (len == 5 && !std::strncmp(json + start, "false", 5))
+				token.type = TokenType::False;
+			else if (len == 4 && !std::strncmp(json + start, "null", 4))
+				token.type = TokenType::Null;
+			else
+				error("illegal identifier : \"" + std::string(json + start, len) + "\"", ptr);
+
+			token.pos = ptr;
+		}
+		// special characters
+		else
+		{
+			switch (c)
+			{
+			case '{':
+				token.type = TokenType::LeftBrace;
+				break;
+			case '}':
+				token.type = TokenType::RightBrace;
+				break;
+			case '[':
+				token.type = TokenType::LeftBracket;
+				break;
+			case ']':
+				token.type = TokenType::RightBracket;
+				break;
+			case ':':
+				token.type = TokenType::Colon;
+				break;
+			case ',':
+				token.type = TokenType::Comma;
+				break;
+			default:
+				error("illegal character '" + std::string(1, c) + "'", ptr);
+				break;
 			}
+			token.pos = ptr;
+			ptr++;
 		}
-		tokens.push_back(Token(TokenType::End, "", ptr));
 	}
 
 	// Parsing functions
 
 	void Parser::error_parser(const std::string &err)
 	{
-		error(err, tokens[MIN(tokens.size() - 1, idx)].pos);
+		error(err, token.pos);
 	}
 
 	bool Parser::is_match(TokenType t)
 	{
-		if (idx >= tokens.size())
-			error_parser("unexpected end in input");
-		return tokens[idx].type == t;
+		return token.type == t;
 	}
 
 	void Parser::must_match(TokenType t, const std::string &err)
@@ -245,43 +265,40 @@ namespace JSON
 
 	void Parser::next()
 	{
-		idx++;
-		if (idx >= tokens.size())
+		if (token.type == TokenType::End)
 			error_parser("unexpected end in input");
+		tokenize();
 	}
 
 	// search for keyword in "map", returns index in map or -1 if not found
 	int Parser::search(const std::string &s)
 	{
-		int p = -1;
-		for (int i = 0; i < keymap->size(); i++)
-			if (dict < (*keymap)[i].size() && (*keymap)[i][dict] == s)
-			{
-				p = i;
-				break;
-			}
-		return p;
+		auto it = keys.find(s);
+		return it == keys.end() ? -1 : it->second;
 	}
 
-	Value Parser::parse_value(std::shared_ptr<JSON> o)
+	Value Parser::parse_value(JSON *o)
 	{
 		Value v = Value();
 		v.setNull();
-		switch (tokens[idx].type)
+		switch (token.type)
 		{
 		case TokenType::Integer:
-			v.setInt(Util::Parse::Integer(tokens[idx].text));
+			v.setInt(Util::Parse::Integer(token.text));
 			break;
 		case TokenType::FloatingPoint:
-			v.setFloat(Util::Parse::Float(tokens[idx].text));
+			v.setFloat(Util::Parse::Float(token.text));
 			break;
 		case TokenType::True:
 			v.setBool(true);
 			break;
 		case TokenType::LeftBrace:
-			o->objects.push_back(parse_core());
-			v.setObject(o->objects.back().get());
+		{
+			JSON *child = o->newObject();
+			parse_core(child);
+			v.setObject(child);
 			break;
+		}
 		case TokenType::False:
 			v.setBool(false);
 			break;
@@ -290,18 +307,18 @@ namespace JSON
 			break;
 		case TokenType::String:
 
-			o->strings.push_back(std::shared_ptr<std::string>(new std::string(tokens[idx].text)));
-			v.setString(o->strings.back().get());
+			v.setString(o->newString(token.text));
 
 			break;
 		case TokenType::LeftBracket:
-			o->arrays.push_back(std::shared_ptr<std::vector<Value>>(new std::vector<Value>()));
+		{
+			std::vector<Value> *a = o->newArray();
 
 			next();
 
 			while (!is_match(TokenType::RightBracket))
 			{
-				o->arrays.back()->push_back(parse_value(o));
+				a->push_back(parse_value(o));
 				next();
 				if (!is_match(TokenType::Comma))
 					break;
@@ -311,9 +328,9 @@ namespace JSON
 			}
 
 			must_match(TokenType::RightBracket, "expected ']'");
-			v.setArray(o->arrays.back().get());
-
+			v.setArray(a);
 			break;
+		}
 		case TokenType::End:
 			error_parser("unexpected end of file");
 
@@ -324,20 +341,18 @@ namespace JSON
 		return v;
 	}
 
-	std::shared_ptr<JSON> Parser::parse_core()
+	void Parser::parse_core(JSON *o)
 	{
-		std::shared_ptr<JSON> o = std::shared_ptr<JSON>(new JSON());
-
 		must_match(TokenType::LeftBrace, "expected '{'");
 		next();
 
 		while (is_match(TokenType::String))
 		{
-			int p = search(tokens[idx].text);
+			int p = search(token.text);
 			if (p < 0)
 			{
 				if (!skipUnknownKeys)
-					error_parser("\"" + tokens[idx].text + "\" is not an allowed \"key\"");
+					error_parser("\"" + token.text + "\" is not an allowed \"key\"");
 			}
 			next();
 
@@ -355,17 +370,25 @@ namespace JSON
 		}
 
 		must_match(TokenType::RightBrace, "expected '}'");
-		return o;
 	}
+
 	std::shared_ptr<JSON> Parser::parse(const std::string &j)
 	{
-		json = j;
-		idx = 0;
-		tokenizer();
-		auto result = parse_core();
+		json = j.c_str();
+		size = (int)j.size();
+		ptr = 0;
+		tokenize();
+
+		// the previous document and its storage are reused once the caller has released it
+		if (!doc || doc.use_count() > 1)
+			doc = std::shared_ptr<JSON>(new JSON());
+		else
+			doc->clear();
+
+		parse_core(doc.get());
 		next();
 		must_match(TokenType::End, "expected END");
 
-		return result;
+		return doc;
 	}
 }
@@ -20,6 +20,7 @@
 #include <vector>
 #include <iostream>
 #include <memory>
+#include <unordered_map>
 
 #include "JSON.h"
 
@@ -27,14 +28,18 @@ namespace JSON {
 
 	class Parser {
 	private:
-		struct Token;
-
 		const std::vector<std::vector<std::string>>* keymap = nullptr;
 		int dict = 0;
 		bool skipUnknownKeys = false;
 
-		std::string json;
-		std::vector<Token> tokens;
+		// key name -> index in keymap for the active dictionary
+		std::unordered_map<std::string, int> keys;
+		void buildKeys();
+
+		// input of the current parse(), the caller's string is not copied
+		const char* json = nullptr;
+		int size = 0;
+		int ptr = 0;
 
 		enum class TokenType {
 			LeftBrace,
@@ -52,42 +57,42 @@ namespace JSON {
 			End
 		};
 
+		// current token, next() reads the following one from the input on demand
+		// text holds the decoded string or number and is reused across tokens and documents
 		struct Token {
 			int pos = 0;
-			TokenType type;
+			TokenType type = TokenType::End;
 			std::string text;
-
-			Token(TokenType t, const std::string& x, int p) {
-				pos = p;
-				type = t;
-				text = x;
-			}
-		};
+		} token;
 
 		void error(const std::string& err, int pos);
 
 		// tokenizer
-		void skip_whitespace(int&);
-		void tokenizer();
+		void skip_whitespace();
+		void tokenize();
 
 		// parser
-		int idx = 0;
-
 		void error_parser(const std::string& err);
 		bool is_match(TokenType t);
 		void must_match(TokenType t, const std::string& err);
 		int search(const std::string& s);
 		void next();
-		std::shared_ptr<JSON> parse_core();
-		Value parse_value(std::shared_ptr<JSON>);
+		void parse_core(JSON*);
+		Value parse_value(JSON*);
+
+		// last document returned by parse()
+		std::shared_ptr<JSON> doc;
 
 	public:
-		Parser(const std::vector<std::vector<std::string>>* map, int d) : keymap(map), dict(d) {}
-		Parser(const std::vector<std::vector<std::string>>* map) : keymap(map) {}
+		Parser(const std::vector<std::vector<std::string>>* map, int d) : keymap(map), dict(d) { buildKeys(); }
+		Parser(const std::vector<std::vector<std::string>>* map) : keymap(map) { buildKeys(); }
 
 		std::shared_ptr<JSON> parse(const std::string& j);
 		void setSkipUnknown(bool b) { skipUnknownKeys = b; }
 		// dictionary to use
-		void setMap(int d) { dict = d; }
+		void setMap(int d) {
+			dict = d;
+			buildKeys();
+		}
 	};
 }
@@ -24,9 +24,82 @@ namespace JSON {
 
 	// StringBuilder - Build string from JSON object
 
-	void StringBuilder::stringify(const std::string& str, std::string& json, bool esc) {
+	void StringBuilder::buildKeys() {
+		keys.clear();
+		keys.reserve(keymap->size());
+
+		// not every row has an entry for every dictionary, e.g. only the settings keys have one for JSON_DICT_SETTING
+		for (const auto& k : *keymap) {
+			const std::string key = dict < k.size() ? k[dict] : std::string();
+			keys.push_back(key.empty() ? std::string() : "\"" + key + "\":");
+		}
+	}
+
+	void StringBuilder::append(long int i, std::string& json) {
+		char buf[24];
+		char* end = buf + sizeof(buf);
+		char* p = end;
+
+		unsigned long int u = i < 0 ? 0UL - (unsigned long int)i : (unsigned long int)i;
+		do {
+			*--p = '0' + (char)(u % 10);
+			u /= 10;
+		} while (u);
+
+		if (i < 0) *--p = '-';
+		json.append(p, end - p);
+	}
+
+	// same output as std::to_string (printf "%f"), i.e. six decimals. The scaled value is rounded in integer arithmetic
+	// unless it lies too close to a rounding tie to decide from the double product, then printf decides.
+	void StringBuilder::append(double f, std::string& json) {
+		double a = std::fabs(f);
+
+		if (a < 1e9) {
+			double x = a * 1e6;
+			double fl = std::floor(x);
+			double frac = x - fl;
+
+			if (std::fabs(frac - 0.5) > x * 1e-15) {
+				unsigned long long n = (unsigned long long)fl + (frac > 0.5 ? 1 : 0);
+				unsigned long long ip = n / 1000000;
+				unsigned int fp = (unsigned int)(n % 1000000);
+
+				char buf[32];
+				char* end = buf + sizeof(buf);
+				char* p = end;
+
+				for (int d = 0; d < 6; d++) {
+					*--p = '0' + (char)(fp % 10);
+					fp /= 10;
+				}
+				*--p = '.';
+				do {
+					*--p = '0' + (char)(ip % 10);
+					ip /= 10;
+				} while (ip);
+
+				if (std::signbit(f)) *--p = '-';
+				json.append(p, end - p);
+				return;
+			}
+		}
+		json += std::to_string(f);
+	}
+
+	void StringBuilder::stringify(const char* str, int len, std::string& json, bool esc) {
 		if (esc) json += '\"';
-		for (char c : str) {
+
+		// copy runs of characters that need no escaping in one go
+		int start = 0;
+		for (int i = 0; i < len; i++) {
+			char c = str[i];
+			if (c != '\"' && c != '\\' && c != '\r' && c != '\0' && c != '\n')
+				continue;
+
+			json.append(str + start, i - start);
+			start = i + 1;
+
 			switch (c) {
 			case '\"':
 				json += "\\\"";
@@ -34,16 +107,15 @@ namespace JSON {
 			case '\\':
 				json += "\\\\";
 				break;
-			case '\r':			
-			case '\0':				
-				break;
 			case '\n':
 				json += "\\n";
 				break;
 			default:
-				json += c;
+				break;
 			}
 		}
+		json.append(str + start, len - start);
+
 		if (esc) json += '\"';
 	}
 
@@ -57,16 +129,16 @@ namespace JSON {
 		}
 		else if (v.isArrayString()) {
 
-			const std::vector<std::string>& as = v.getStringArray();
+			const Util::Lines& as = v.getStringArray();
 
 			json += '[';
 
 			if (as.size()) {
-				stringify(as[0], json);
+				stringify(as[0].c_str(), as[0].length(), json);
 
 				for (int i = 1; i < as.size(); i++) {
 					json += ',';
-					stringify(as[i], json);
+					stringify(as[i].c_str(), as[i].length(), json);
 				}
 			}
 
@@ -89,6 +161,12 @@ namespace JSON {
 
 			json += ']';
 		}
+		else if (v.isInt()) {
+			append(v.getInt(), json);
+		}
+		else if (v.isFloat()) {
+			append(v.getFloat(), json);
+		}
 		else
 			v.to_string(json);
 	}
@@ -98,14 +176,14 @@ namespace JSON {
 		json += '{';
 		for (const Property& p : object.getProperties()) {
 
-			const std::string& key = (*keymap)[p.Key()][dict];
+			const std::string& key = keys[p.Key()];
 
 			if (!key.empty()) {
 
 				if (!first) json += ',';
 				first = false;
 
-				json += "\"" + key + "\":";
+				json += key;
 				to_string(json, p.Get());
 			}
 		}
@@ -32,21 +32,31 @@ namespace JSON {
 		const std::vector<std::vector<std::string>>* keymap = nullptr;
 		int dict = 0;
 
+		// "key": prefixes for the active dictionary, empty if the key is not part of it
+		std::vector<std::string> keys;
+		void buildKeys();
 
 	public:
-		StringBuilder(const std::vector<std::vector<std::string>>* map, int d) : keymap(map), dict(d) {}
-		StringBuilder(const std::vector<std::vector<std::string>>* map) : keymap(map) {}
+		StringBuilder(const std::vector<std::vector<std::string>>* map, int d) : keymap(map), dict(d) { buildKeys(); }
+		StringBuilder(const std::vector<std::vector<std::string>>* map) : keymap(map) { buildKeys(); }
 
 		void to_string(std::string& json, const Value& v);
 		void stringify(const JSON& properties, std::string& json);
-		static void stringify(const std::string& str, std::string& json, bool esc = true);
+		static void stringify(const char* str, int len, std::string& json, bool esc = true);
+		static void stringify(const std::string& str, std::string& json, bool esc = true) { stringify(str.c_str(), (int)str.length(), json, esc); }
 		std::string stringify(const JSON& properties) {
 			std::string j;
 			stringify(properties, j);
 			return j;
 		}
 
+		static void append(long int i, std::string& json);
+		static void append(double f, std::string& json);
+
 		// dictionary to use
-		void setMap(int d) { dict = d; }
+		void setMap(int d) {
+			dict = d;
+			buildKeys();
+		}
 	};
 }
@@ -15,6 +15,9 @@
 	along with this program.  If not, see <https://www.gnu.org/licenses/>.
 */
 
+#include <algorithm>
+#include <cstdlib>
+
 #include "AIS.h"
 
 // Sources:
@@ -51,12 +54,53 @@ namespace AIS
 		}
 	}
 
+	// FCS (CRC-16/X.25, reflected polynomial 0x8408) over one byte of bits in transmission order
+	static const uint16_t crc_table[256] = {
+		0x0000, 0x1189, 0x2312, 0x329b, 0x4624, 0x57ad, 0x6536, 0x74bf,
+		0x8c48, 0x9dc1, 0xaf5a, 0xbed3, 0xca6c, 0xdbe5, 0xe97e, 0xf8f7,
+		0x1081, 0x0108, 0x3393, 0x221a, 0x56a5, 0x472c, 0x75b7, 0x643e,
+		0x9cc9, 0x8d40, 0xbfdb, 0xae52, 0xdaed, 0xcb64, 0xf9ff, 0xe876,
+		0x2102, 0x308b, 0x0210, 0x1399, 0x6726, 0x76af, 0x4434, 0x55bd,
+		0xad4a, 0xbcc3, 0x8e58, 0x9fd1, 0xeb6e, 0xfae7, 0xc87c, 0xd9f5,
+		0x3183, 0x200a, 0x1291, 0x0318, 0x77a7, 0x662e, 0x54b5, 0x453c,
+		0xbdcb, 0xac42, 0x9ed9, 0x8f50, 0xfbef, 0xea66, 0xd8fd, 0xc974,
+		0x4204, 0x538d, 0x6116, 0x709f, 0x0420, 0x15a9, 0x2732, 0x36bb,
+		0xce4c, 0xdfc5, 0xed5e, 0xfcd7, 0x8868, 0x99e1, 0xab7a, 0xbaf3,
+		0x5285, 0x430c, 0x7197, 0x601e, 0x14a1, 0x0528, 0x37b3, 0x263a,
+		0xdecd, 0xcf44, 0xfddf, 0xec56, 0x98e9, 0x8960, 0xbbfb, 0xaa72,
+		0x6306, 0x728f, 0x4014, 0x519d, 0x2522, 0x34ab, 0x0630, 0x17b9,
+		0xef4e, 0xfec7, 0xcc5c, 0xddd5, 0xa96a, 0xb8e3, 0x8a78, 0x9bf1,
+		0x7387, 0x620e, 0x5095, 0x411c, 0x35a3, 0x242a, 0x16b1, 0x0738,
+		0xffcf, 0xee46, 0xdcdd, 0xcd54, 0xb9eb, 0xa862, 0x9af9, 0x8b70,
+		0x8408, 0x9581, 0xa71a, 0xb693, 0xc22c, 0xd3a5, 0xe13e, 0xf0b7,
+		0x0840, 0x19c9, 0x2b52, 0x3adb, 0x4e64, 0x5fed, 0x6d76, 0x7cff,
+		0x9489, 0x8500, 0xb79b, 0xa612, 0xd2ad, 0xc324, 0xf1bf, 0xe036,
+		0x18c1, 0x0948, 0x3bd3, 0x2a5a, 0x5ee5, 0x4f6c, 0x7df7, 0x6c7e,
+		0xa50a, 0xb483, 0x8618, 0x9791, 0xe32e, 0xf2a7, 0xc03c, 0xd1b5,
+		0x2942, 0x38cb, 0x0a50, 0x1bd9, 0x6f66, 0x7eef, 0x4c74, 0x5dfd,
+		0xb58b, 0xa402, 0x9699, 0x8710, 0xf3af, 0xe226, 0xd0bd, 0xc134,
+		0x39c3, 0x284a, 0x1ad1, 0x0b58, 0x7fe7, 0x6e6e, 0x5cf5, 0x4d7c,
+		0xc60c, 0xd785, 0xe51e, 0xf497, 0x8028, 0x91a1, 0xa33a, 0xb2b3,
+		0x4a44, 0x5bcd, 0x6956, 0x78df, 0x0c60, 0x1de9, 0x2f72, 0x3efb,
+		0xd68d, 0xc704, 0xf59f, 0xe416, 0x90a9, 0x8120, 0xb3bb, 0xa232,
+		0x5ac5, 0x4b4c, 0x79d7, 0x685e, 0x1ce1, 0x0d68, 0x3ff3, 0x2e7a,
+		0xe70e, 0xf687, 0xc41c, 0xd595, 0xa12a, 0xb0a3, 0x8238, 0x93b1,
+		0x6b46, 0x7acf, 0x4854, 0x59dd, 0x2d62, 0x3ceb, 0x0e70, 0x1ff9,
+		0xf78f, 0xe606, 0xd49d, 0xc514, 0xb1ab, 0xa022, 0x92b9, 0x8330,
+		0x7bc7, 0x6a4e, 0x58d5, 0x495c, 0x3de3, 0x2c6a, 0x1ef1, 0x0f78
+	};
+
 	bool Decoder::CRC16(int len)
 	{
 		const uint16_t checksum = ~0x0F47, poly = 0x8408;
 		uint16_t CRC = 0xFFFF;
+		int i = 0;
 
-		for (int i = 0; i < len; i++)
+		// bits are stored LSB first, so whole bytes go through the table and the tail bit by bit
+		for (; i + 8 <= len; i += 8)
+			CRC = (CRC >> 8) ^ crc_table[(CRC ^ msg.getByte(i >> 3)) & 0xFF];
+
+		for (; i < len; i++)
 			CRC = ((uint16_t)msg.getBit(i) ^ CRC) & 1 ? (CRC >> 1) ^ poly : CRC >> 1;
 
 		return CRC == checksum;
@@ -141,92 +185,194 @@ namespace AIS
 		return false;
 	}
 
+	// earliest symbol (1 = the next) at which this decoder could complete a message and reset the others:
+	// a message needs at least 16 bits after the start flag and ends with six ones
+	int Decoder::Horizon() const
+	{
+		if (state != State::DATAFCS)
+			return 24;
+
+		return std::max(std::max(6 - one_seq_count, 23 - position), 1);
+	}
+
 	void Decoder::Receive(const FLOAT32 *data, int len, TAG &tag)
 	{
-		for (int i = 0; i < len; i++)
+		if (group)
 		{
-			// NRZI
-			BIT d = data[i] > 0;
-			BIT Bit = !(d ^ prev);
-			prev = d;
+			pending.assign(data, data + len);
+			group->Receive(tag);
+			return;
+		}
+
+		for (int i = 0; i < len; i++)
+			Next(data[i], tag.sample_idx, tag.sample_lvl, tag);
+	}
+
+	void Decoder::Next(FLOAT32 x, long idx, float lvl, TAG &tag)
+	{
+		// NRZI
+		BIT d = x > 0;
+		BIT Bit = !(d ^ prev);
+		prev = d;
 
-			// State machine
-			// At this stage: "position" bits into sequence, inspect the next bit:
+		// State machine
+		// At this stage: "position" bits into sequence, inspect the next bit:
 
-			switch (state)
+		switch (state)
+		{
+		case State::TRAINING:
+			if (Bit != lastBit) // 01 10
 			{
-			case State::TRAINING:
-				if (Bit != lastBit) // 01 10
-				{
-					position++;
-				}
-				else // 11 or 00
-				{
-					if (position > MIN_TRAINING_BITS) {
-						start_idx = tag.sample_idx;
-						NextState(State::STARTFLAG, Bit ? 3 : 1); // we are at * in ..0101|01*111110 ..010|*01111110
-					}
-					else
-						NextState(State::TRAINING, 0);
+				position++;
+			}
+			else // 11 or 00
+			{
+				if (position > MIN_TRAINING_BITS) {
+					start_idx = idx;
+					NextState(State::STARTFLAG, Bit ? 3 : 1); // we are at * in ..0101|01*111110 ..010|*01111110
 				}
-				break;
-			case State::STARTFLAG:
+				else
+					NextState(State::TRAINING, 0);
+			}
+			break;
+		case State::STARTFLAG:
 
-				if (position == 7)
+			if (position == 7)
+			{
+				if (Bit == 0)
 				{
-					if (Bit == 0)
-					{
-						NextState(State::DATAFCS, 0); // 0111111*0....
-						level = 0.0f;
-					}
-					else
-						NextState(State::TRAINING, 0);
+					NextState(State::DATAFCS, 0); // 0111111*0....
+					level = 0.0f;
 				}
 				else
-				{
-					if (Bit == 1)
-						position++;
-					else
-						NextState(State::TRAINING, 0);
-				}
-				break;
-			case State::DATAFCS:
+					NextState(State::TRAINING, 0);
+			}
+			else
+			{
+				if (Bit == 1)
+					position++;
+				else
+					NextState(State::TRAINING, 0);
+			}
+			break;
+		case State::DATAFCS:
 
-				msg.setBit(position++, Bit);
+			msg.setBit(position++, Bit);
 
-				// add power of signal of bit length
-				if (tag.mode & 1)
-					level += tag.sample_lvl;
+			// add power of signal of bit length
+			if (tag.mode & 1)
+				level += lvl;
 
-				if (Bit == 1)
+			if (Bit == 1)
+			{
+				if (one_seq_count == 5)
 				{
-					if (one_seq_count == 5)
-					{
-						if (tag.mode & 1)
-							tag.level = level / position;
-						end_idx = tag.sample_idx;
-						if (processData(position - 7, tag))
-							NextState(State::FOUNDMESSAGE, 0);
-						NextState(State::TRAINING, 0);
-					}
-					else
-						one_seq_count++;
+					if (tag.mode & 1)
+						tag.level = level / position;
+					end_idx = idx;
+					if (processData(position - 7, tag))
+						NextState(State::FOUNDMESSAGE, 0);
+					NextState(State::TRAINING, 0);
 				}
 				else
+					one_seq_count++;
+			}
+			else
+			{
+				if (one_seq_count == 5)
+					position--; // bit-destuff
+				one_seq_count = 0;
+			}
+
+			if (position == MaxBits || (QuickReset && canStop(position)))
+				NextState(State::TRAINING, 0);
+			break;
+
+		default:
+			break;
+		}
+		lastBit = Bit;
+	}
+
+	// all decoders hold a block of the same length: symbol k of decoder j has sample index tag.sample_idx + k * n + j
+	void DecoderGroup::Receive(TAG &tag)
+	{
+		if (++arrived < decoders.size())
+			return;
+
+		arrived = 0;
+
+		const int n = (int)decoders.size();
+		const int len = (int)decoders[0]->pending.size();
+		const long base = tag.sample_idx;
+
+		int k = 0;
+
+		while (k < len)
+		{
+			// symbols that all decoders can process before any of them could reset the others, at least one in lockstep
+			int run = len - k;
+			for (Decoder *d : decoders)
+				run = std::min(run, d->Horizon() - 1);
+
+			if (run > 0)
+			{
+				for (int j = 0; j < n; j++)
 				{
-					if (one_seq_count == 5)
-						position--; // bit-destuff
-					one_seq_count = 0;
+					Decoder &d = *decoders[j];
+					for (int i = k; i < k + run; i++)
+						d.Next(d.pending[i], base + (long)i * n + j, tag.sample_lvls ? tag.sample_lvls[i] : tag.sample_lvl, tag);
 				}
+				k += run;
+			}
+			else
+			{
+				for (int j = 0; j < n; j++)
+					decoders[j]->Next(decoders[j]->pending[k], base + (long)k * n + j, tag.sample_lvls ? tag.sample_lvls[k] : tag.sample_lvl, tag);
+				k++;
+			}
+		}
+	}
 
-				if (position == MaxBits || (QuickReset && canStop(position)))
-					NextState(State::TRAINING, 0);
-				break;
+	std::atomic<uint64_t> DecoderDedup::unique(0);
+	std::atomic<uint64_t> DecoderDedup::dropped(0);
 
-			default:
-				break;
+	bool DecoderDedup::isDuplicate(const Message &msg)
+	{
+		// the 16 FCS bits are still in the buffer behind the payload
+		Frame f;
+		f.channel = msg.getChannel();
+		f.length = msg.getLength();
+		f.fcs = msg.getUint(f.length, 16);
+		f.start_idx = msg.getStartIdx();
+
+		for (const Frame &r : recent)
+		{
+			if (r.length == f.length && r.fcs == f.fcs && r.channel == f.channel && std::abs(r.start_idx - f.start_idx) <= WINDOW)
+			{
+				dropped++;
+				return true;
 			}
-			lastBit = Bit;
 		}
+
+		recent[next] = f;
+		next = (next + 1) % N_FRAMES;
+		unique++;
+
+		return false;
+	}
+
+	void DecoderDedup::Receive(const Message *data, int len, TAG &tag)
+	{
+		for (int i = 0; i < len; i++)
+			if (!isDuplicate(data[i]))
+				Send(data + i, 1, tag);
+	}
+
+	void DecoderDedup::Receive(Message *data, int len, TAG &tag)
+	{
+		for (int i = 0; i < len; i++)
+			if (!isDuplicate(data[i]))
+				Send(data + i, 1, tag);
 	}
 }
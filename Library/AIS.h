@@ -35,8 +35,12 @@ namespace AIS
 		FOUNDMESSAGE
 	};
 
+	class DecoderGroup;
+
 	class Decoder : public SimpleStreamInOut<FLOAT32, Message>, public SignalIn<DecoderSignals>
 	{
+		friend class DecoderGroup;
+
 		char channel = '?';
 		int station = 0;
 		int own_mmsi = -1;
@@ -69,6 +73,13 @@ namespace AIS
 		long start_idx = 0;
 		long end_idx = 0;
 
+		// block input collected for the group, see DecoderGroup
+		DecoderGroup *group = nullptr;
+		std::vector<FLOAT32> pending;
+
+		inline void Next(FLOAT32 x, long idx, float lvl, TAG &tag);
+		int Horizon() const;
+
 	public:
 		virtual ~Decoder() {}
 
@@ -86,4 +97,56 @@ namespace AIS
 		// MessageOut
 		SignalHub<DecoderSignals> DecoderMessage;
 	};
+
+	// Decoders on the symbol phases of a channel reset each other when one of them finds a message. With block
+	// input (DSP::ScatterPLL::setBlocks) the group collects a block for every decoder and then runs them in lockstep
+	// only where a decoder could complete a message. Elsewhere each decoder runs through its block by itself.
+	class DecoderGroup
+	{
+		std::vector<Decoder *> decoders;
+		int arrived = 0;
+
+	public:
+		void add(Decoder &d)
+		{
+			d.group = this;
+			decoders.push_back(&d);
+		}
+
+		void Receive(TAG &tag);
+	};
+
+	// Drops a frame that was already delivered by another decoder of the channel: same channel, length and FCS,
+	// starting within half a slot. Decoders reset each other on a find, this catches what slips through (e.g. the
+	// coherent and FM decoders in ModelChallenger, which see the channel block by block). Counters are process-wide.
+	class DecoderDedup : public SimpleStreamInOut<Message, Message>
+	{
+		struct Frame
+		{
+			char channel = 0;
+			int length = -1;
+			unsigned fcs = 0;
+			long start_idx = 0;
+		};
+
+		// AIS has 2250 slots per minute, 1280 samples at 48K, a new transmission cannot start within half of that
+		static const long WINDOW = 640;
+		static const int N_FRAMES = 16;
+
+		Frame recent[N_FRAMES];
+		int next = 0;
+
+		static std::atomic<uint64_t> unique, dropped;
+
+		bool isDuplicate(const Message &msg);
+
+	public:
+		virtual ~DecoderDedup() {}
+
+		void Receive(const Message *data, int len, TAG &tag);
+		void Receive(Message *data, int len, TAG &tag);
+
+		static uint64_t getUnique() { return unique; }
+		static uint64_t getDropped() { return dropped; }
+	};
 }
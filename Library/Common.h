@@ -212,6 +212,7 @@ struct TAG
 	FLOAT32 station_lat = LAT_UNDEFINED;
 	FLOAT32 station_lon = LON_UNDEFINED;
 	long sample_idx = 0;
+	const float *sample_lvls = nullptr; // level per symbol group for blocks from DSP::ScatterPLL
 	long msg_idx_start, msg_idx_end;
 	uint32_t ipv4 = 0;
 
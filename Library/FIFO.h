@@ -19,37 +19,92 @@
 
 #include <mutex>
 #include <condition_variable>
+#include <atomic>
 
 #include <vector>
 #include <chrono>
 #include <cstring>
+#include <string>
 
 // FIFO implementation: input (Push) can be any size, output (Pop) will be of size BLOCK_SIZE
+// Single producer (Push) and single consumer (Wait/Front/Pop): the data path is lock-free,
+// the mutex and condition variables are only used when one side is actually asleep.
 
 class FIFO
 {
 	std::vector<char> _data;
 
-	int head = 0;
+	int BLOCK_SIZE = 16 * 16384;
+	int N_BLOCKS = 2;
+
+	const static int timeout = 1500;
+	const static int CACHE_LINE = 64;
+
+	// shared between producer and consumer
+	std::atomic<int> blocks_filled;
+	std::atomic<bool> halted;
+	char pad0[CACHE_LINE];
+
+	// producer side
 	int tail = 0;
+	std::atomic<bool> producer_waiting;
+	std::atomic<int> high_water;
+	std::atomic<long> overruns;
+	char pad1[CACHE_LINE];
 
-	int blocks_filled = 0;
+	// consumer side
+	int head = 0;
+	std::atomic<bool> consumer_waiting;
+	char pad2[CACHE_LINE];
 
 	std::mutex fifo_mutex;
 	std::condition_variable fifo_notempty;
 	std::condition_variable fifo_notfull;
 
-	int BLOCK_SIZE = 16 * 16384;
-	int N_BLOCKS = 2;
+	void wakeConsumer()
+	{
+		if (consumer_waiting)
+		{
+			std::lock_guard<std::mutex> lock(fifo_mutex);
+			fifo_notempty.notify_one();
+		}
+	}
 
-	const static int timeout = 1500;
+	void wakeProducer()
+	{
+		if (producer_waiting)
+		{
+			std::lock_guard<std::mutex> lock(fifo_mutex);
+			fifo_notfull.notify_one();
+		}
+	}
+
+	// writable, contiguous region at the tail of at most sz bytes, the ring must not be full
+	char *Grant(int &sz)
+	{
+		int available = (N_BLOCKS - blocks_filled) * BLOCK_SIZE - tail % BLOCK_SIZE;
+		int contiguous = (int)_data.size() - tail;
+
+		if (sz > available)
+			sz = available;
+		if (sz > contiguous)
+			sz = contiguous;
+
+		return _data.data() + tail;
+	}
 
 public:
+	FIFO() : blocks_filled(0), halted(false), producer_waiting(false), high_water(0), overruns(0), consumer_waiting(false) {}
+
 	void Init(int bs = 16 * 16384, int fs = 2)
 	{
 		BLOCK_SIZE = bs;
 		N_BLOCKS = fs;
-		blocks_filled = head = tail = 0;
+		head = tail = 0;
+		blocks_filled = 0;
+		high_water = 0;
+		overruns = 0;
+		halted = false;
 		_data.resize((int)(N_BLOCKS * BLOCK_SIZE));
 	}
 
@@ -58,25 +113,48 @@ public:
 		return BLOCK_SIZE;
 	}
 
+	int BlockCount()
+	{
+		return N_BLOCKS;
+	}
+
+	// statistics, maintained by the producer
+	long getOverruns()
+	{
+		return overruns;
+	}
+
+	int getHighWater()
+	{
+		return high_water;
+	}
+
+	std::string getStatus()
+	{
+		return "high water " + std::to_string(high_water) + "/" + std::to_string(N_BLOCKS) + " blocks, overruns " + std::to_string(overruns);
+	}
+
 	void Halt()
 	{
 		std::lock_guard<std::mutex> lock(fifo_mutex);
 
-		blocks_filled = -1;
+		halted = true;
 		fifo_notempty.notify_one();
 		fifo_notfull.notify_one();
 	}
 
 	bool Wait()
 	{
-		std::unique_lock<std::mutex> lock(fifo_mutex);
-
-		if (blocks_filled == 0)
+		if (blocks_filled == 0 && !halted)
 		{
+			std::unique_lock<std::mutex> lock(fifo_mutex);
+
+			consumer_waiting = true;
 			fifo_notempty.wait_for(lock, std::chrono::milliseconds((int)(timeout)), [this]
-							   { return blocks_filled != 0; });
+								   { return blocks_filled != 0 || halted; });
+			consumer_waiting = false;
 		}
-		return blocks_filled > 0;
+		return !halted && blocks_filled > 0;
 	}
 
 	char *Front()
@@ -87,65 +165,124 @@ public:
 	char *Front(int &requested)
 	{
 		int to_wrap = ((_data.size() - head) / BLOCK_SIZE);
+		int filled = blocks_filled;
 
 		if (requested < 0)
 			requested = to_wrap;
-		if (blocks_filled < requested)
-			requested = blocks_filled;
+		if (filled < requested)
+			requested = filled;
 
 		return _data.data() + head;
 	}
 
 	void Pop(int count = 1)
 	{
-		std::unique_lock<std::mutex> lock(fifo_mutex);
+		int filled = blocks_filled;
 
-		if (blocks_filled < count)
-			count = blocks_filled;
+		if (filled < count)
+			count = filled;
 
 		if (count > 0)
 		{
 			head = (head + count * BLOCK_SIZE) % (int)_data.size();
 			blocks_filled -= count;
-			fifo_notfull.notify_one();
+			wakeProducer();
 		}
 	}
 
 	bool Full()
 	{
-		std::unique_lock<std::mutex> lock(fifo_mutex);
-
 		return blocks_filled == N_BLOCKS;
 	}
 
-	bool Push(char *data, int sz, bool wait = false)
+	// zero-copy producer interface: Lease returns a writable, contiguous region at the tail of at most sz bytes
+	// (sz is updated to the granted size) so the source can read straight into the ring, Commit publishes
+	// the bytes actually written. Returns nullptr when the ring is full (and wait is false) or halted.
+	char *Lease(int &sz, bool wait = false)
+	{
+		if (halted)
+			return nullptr;
+
+		if (blocks_filled == N_BLOCKS)
+		{
+			if (!wait)
+			{
+				overruns++;
+				return nullptr;
+			}
+
+			std::unique_lock<std::mutex> lock(fifo_mutex);
+
+			producer_waiting = true;
+			fifo_notfull.wait(lock, [this]
+							  { return halted || blocks_filled < N_BLOCKS; });
+			producer_waiting = false;
+
+			if (halted)
+				return nullptr;
+		}
+
+		return Grant(sz);
+	}
+
+	// as Lease without waiting, but a full ring is not counted as an overrun: for callers that fall back
+	// to Push, which counts the transfer if it is really dropped
+	char *TryLease(int &sz)
 	{
-		std::unique_lock<std::mutex> lock(fifo_mutex);
+		if (halted || blocks_filled == N_BLOCKS)
+			return nullptr;
+
+		return Grant(sz);
+	}
 
+	void Commit(int sz)
+	{
+		if (sz <= 0)
+			return;
+
+		int blocks_ready = (tail % BLOCK_SIZE + sz) / BLOCK_SIZE;
+		tail = (tail + sz) % (int)_data.size();
+
+		if (blocks_ready > 0)
+		{
+			int filled = (blocks_filled += blocks_ready);
+
+			if (filled > high_water)
+				high_water = filled;
+
+			wakeConsumer();
+		}
+	}
+
+	bool Push(char *data, int sz, bool wait = false)
+	{
 		if (sz <= 0)
 			return true;
 
 		// size of new tail block including overflow (i.e. > BLOCK_SIZE)
-		int blocks_ready = (tail % BLOCK_SIZE + sz) / BLOCK_SIZE;
 		int blocks_needed = (tail % BLOCK_SIZE + sz - 1) / BLOCK_SIZE + 1;
 		int wrap = tail + sz - (int)_data.size();
 
-		if (blocks_filled == -1)
+		if (halted)
 			return false;
 
 		if (blocks_filled + blocks_needed > N_BLOCKS)
 		{
-			if (wait)
-			{
-				while (blocks_filled != -1 && (blocks_filled + blocks_needed > N_BLOCKS))
-				{
-					fifo_notfull.wait(lock);
-				}
-			}
-			else
+			if (!wait)
 			{
+				overruns++;
 				return false;
 			}
+
+			std::unique_lock<std::mutex> lock(fifo_mutex);
+
+			producer_waiting = true;
+			fifo_notfull.wait(lock, [this, blocks_needed]
+							  { return halted || blocks_filled + blocks_needed <= N_BLOCKS; });
+			producer_waiting = false;
+
+			if (halted)
+				return false;
 		}
 
 		if (wrap <= 0)
@@ -158,13 +295,7 @@ public:
 			std::memcpy(_data.data(), data + sz - wrap, wrap);
 		}
 
-		tail = (tail + sz) % (int)_data.size();
-
-		if (blocks_ready > 0)
-		{
-			blocks_filled += blocks_ready;
-			fifo_notempty.notify_one();
-		}
+		Commit(sz);
 		return true;
 	}
 };
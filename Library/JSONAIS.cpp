@@ -213,12 +213,25 @@ namespace AIS
 		for (int i = 0; i < len; i++)
 		{
 			json.clear();
-			ProcessMsg(data[i], tag);
 			json.binary = (void *)&data[i];
+
+			current = &data[i];
+			current_tag = &tag;
+			json.setProducer(this);
+
 			Send(&json, 1, tag);
+
+			json.setProducer(nullptr);
+			current = nullptr;
 		}
 	}
 
+	void JSONAIS::produce(JSON::JSON &j)
+	{
+		if (&j == &json && current)
+			ProcessMsg(*current, *current_tag);
+	}
+
 	void JSONAIS::ProcessMsg6Data(const AIS::Message &msg)
 	{
 		int dac = msg.getUint(72, 10);
@@ -25,10 +25,16 @@
 #include "AIS.h"
 
 namespace AIS {
-	class JSONAIS : public SimpleStreamInOut<Message, JSON::JSON> {
+	// the JSON object is sent unpopulated, the message is decoded when a consumer first reads its properties
+	class JSONAIS : public SimpleStreamInOut<Message, JSON::JSON>, public JSON::Producer {
 		JSON::JSON json;
 
+		// message being sent downstream
+		const AIS::Message* current = nullptr;
+		TAG* current_tag = nullptr;
+
 		void ProcessMsg(const AIS::Message& msg, TAG& tag);
+		void produce(JSON::JSON& j);
 
 		const std::string class_str = "AIS";
 		const std::string device = "AIS-catcher";
@@ -119,6 +119,7 @@ namespace AIS
 		{"", "", "", "", "persist"},
 		{"", "", "", "", "plugin"},
 		{"", "", "", "", "plugin_dir"},
+		{"", "", "", "", "polyphase"},
 		{"", "", "", "", "port"},
 		{"", "", "", "", "port_min"},
 		{"", "", "", "", "port_max"},
@@ -158,6 +159,8 @@ namespace AIS
 		{"", "", "", "", "tcp_listener"},
 		{"", "", "", "", "test"},
 		{"", "", "", "", "timeout"},
+		{"", "", "", "", "threaded"},
+		{"", "", "", "", "threads"},
 		{"", "", "", "", "threshold"},
 		{"", "", "", "", "topic"},
 		{"", "", "", "", "tuner"},
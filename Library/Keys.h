@@ -132,6 +132,7 @@ namespace AIS
 		KEY_SETTING_PERSIST,
 		KEY_SETTING_PLUGIN,
 		KEY_SETTING_PLUGIN_DIR,
+		KEY_SETTING_POLYPHASE,
 		KEY_SETTING_PORT,
 		KEY_SETTING_PORT_MIN,
 		KEY_SETTING_PORT_MAX,
@@ -171,6 +172,8 @@ namespace AIS
 		KEY_SETTING_TCP_LISTENER,
 		KEY_SETTING_TEST,
 		KEY_SETTING_TIMEOUT,
+		KEY_SETTING_THREADED,
+		KEY_SETTING_THREADS,
 		KEY_SETTING_THRESHOLD,
 		KEY_SETTING_TOPIC,
 		KEY_SETTING_TUNER,
@@ -20,7 +20,7 @@
 namespace AIS
 {
 
-	int Message::ID = 0;
+	std::atomic<unsigned> Message::ID(0);
 
 	static int NMEAchecksum(const std::string &s)
 	{
@@ -302,43 +302,51 @@ namespace AIS
 		int nAISletters = (length + 6 - 1) / 6;
 		int nSentences = (nAISletters == 0) ? 1 : (nAISletters + MAX_NMEA_CHARS - 1) / MAX_NMEA_CHARS;
 
-		line.resize(11);
+		// header, shared by all sentences except for the sentence number
+		char header[16] = "!AIVDM,X,X,";
+		int h = 11;
 
-		line[IDX_OWN_MMSI] = own_mmsi == mmsi() ? 'O' : 'M';
-		line[IDX_COUNT] = (char)(nSentences + '0');
-		line[IDX_NUMBER] = '0';
+		header[IDX_OWN_MMSI] = own_mmsi == mmsi() ? 'O' : 'M';
+		header[IDX_COUNT] = (char)(nSentences + '0');
 
 		if (nSentences > 1)
 		{
-			line += (char)(ID + '0');
-			ID = (ID + 1) % 10;
+			header[h++] = (char)(ID++ % 10 + '0');
 		}
 
-		line += comma;
+		header[h++] = comma;
 		if (channel != '?')
-			line += channel;
-		line += comma;
+			header[h++] = channel;
+		header[h++] = comma;
 
-		int header = line.length();
 		NMEA.clear();
 
 		for (int s = 0, l = 0; s < nSentences; s++)
 		{
+			// sentences are written in place, the longest is well within a line
+			char line[Util::Line::MAX_LENGTH];
+			int n = h;
 
-			line.resize(header);
-			line[IDX_NUMBER]++;
+			std::memcpy(line, header, h);
+			line[IDX_NUMBER] = (char)(s + 1 + '0');
 
 			for (int i = 0; l < nAISletters && i < MAX_NMEA_CHARS; i++, l++)
-				line += getLetter(l);
+				line[n++] = getLetter(l);
 
-			line += comma;
-			line += (char)(((s == nSentences - 1) ? nAISletters * 6 - length : 0) + '0');
+			line[n++] = comma;
+			line[n++] = (char)(((s == nSentences - 1) ? nAISletters * 6 - length : 0) + '0');
 
-			int c = NMEAchecksum(line);
-			line += '*';
-			line += (c >> 4) < 10 ? (c >> 4) + '0' : (c >> 4) + 'A' - 10;
-			line += (c & 0xF) < 10 ? (c & 0xF) + '0' : (c & 0xF) + 'A' - 10;
-			NMEA.push_back(line);
+			int c = 0;
+			for (int i = 1; i < n; i++)
+				c ^= line[i];
+
+			line[n++] = '*';
+			line[n++] = (c >> 4) < 10 ? (c >> 4) + '0' : (c >> 4) + 'A' - 10;
+			line[n++] = (c & 0xF) < 10 ? (c & 0xF) + '0' : (c & 0xF) + 'A' - 10;
+
+			Util::Line *nmea = NMEA.add();
+			if (nmea)
+				nmea->append(line, n);
 		}
 	}
 
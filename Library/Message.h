@@ -22,6 +22,7 @@
 #include <vector>
 #include <iomanip>
 #include <sstream>
+#include <atomic>
 
 #include "Utilities.h"
 
@@ -52,8 +53,7 @@ namespace AIS
 	{
 	protected:
 		const int MAX_NMEA_CHARS = 56;
-		static int ID;
-		std::string line = "!AIVDM,X,X,X,X," + std::string(MAX_NMEA_CHARS, '.') + ",X*XX\n\r"; // longest line
+		static std::atomic<unsigned> ID;
 
 		uint8_t data[128];
 		std::time_t rxtime;
@@ -64,7 +64,7 @@ namespace AIS
 		int own_mmsi = -1;
 
 	public:
-		std::vector<std::string> NMEA;
+		Util::Lines NMEA;
 
 		void Stamp(std::time_t t = (std::time_t)0L)
 		{
@@ -96,6 +96,11 @@ namespace AIS
 			start_idx = s;
 		}
 
+		long getStartIdx() const
+		{
+			return start_idx;
+		}
+
 		void setEndIdx(long e)
 		{
 			end_idx = e;
@@ -104,7 +109,7 @@ namespace AIS
 		void clear()
 		{
 			length = 0;
-			NMEA.resize(0);
+			NMEA.clear();
 			std::memset(data, 0, 128);
 		}
 
@@ -146,6 +151,11 @@ namespace AIS
 			return data[i >> 3] & (1 << (i & 7));
 		}
 
+		uint8_t getByte(int i) const
+		{
+			return data[i];
+		}
+
 		char getLetter(int pos) const;
 		void setLetter(int pos, char c);
 		void appendLetter(char c) { setLetter(length / 6, c); }
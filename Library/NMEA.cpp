@@ -29,152 +29,189 @@ namespace AIS
 		prev = c;
 	}
 
-	void NMEA::clean(char c, int t)
+	// slot of the multi-sentence message that the current sentence belongs to, slots older than 3 seconds are released
+	NMEA::Multipart *NMEA::search(int thisstation, uint64_t now)
 	{
-		auto i = queue.begin();
-		uint64_t now = time(nullptr);
-		while (i != queue.end())
+		Multipart *found = nullptr;
+
+		for (auto &m : multipart)
 		{
-			if ((i->channel == c && i->talkerID == t) || (i->timestamp + 3 < now))
-				i = queue.erase(i);
-			else
-				i++;
+			if (!m.used)
+				continue;
+
+			if (m.timestamp + 3 < now)
+				m.used = false;
+			else if (m.source == source && m.station == thisstation && m.talkerID == aivdm.talkerID && m.channel == aivdm.channel && m.ID == aivdm.ID)
+				found = &m;
 		}
+		return found;
 	}
 
-	int NMEA::search(const AIVDM &a)
+	// free slot, or the oldest one if all are in use
+	NMEA::Multipart *NMEA::allocate(uint64_t now)
 	{
-		// multiline message, firstly check whether we can find previous lines with the same ID, channel and line count
-		// we run backwards to find the previous addition
-		// return: 0 = Not Found, -1: Found but inconsistent with input, >0: number of previous message
-		int lastNumber = 0;
-		for (auto it = queue.rbegin(); it != queue.rend(); it++)
+		Multipart *slot = &multipart[0];
+
+		for (auto &m : multipart)
 		{
-			if (it->channel == aivdm.channel && it->talkerID == aivdm.talkerID)
+			if (!m.used)
 			{
-				if (it->count != aivdm.count || it->ID != aivdm.ID)
-					lastNumber = -1;
-				else
-					lastNumber = it->number;
+				slot = &m;
 				break;
 			}
+			if (m.timestamp < slot->timestamp)
+				slot = &m;
 		}
-		return lastNumber;
+
+		slot->used = true;
+		slot->timestamp = now;
+		slot->length = 0;
+		slot->number = 0;
+		slot->sentences.clear();
+		slot->fits = true;
+		return slot;
 	}
 
-	int NMEA::NMEAchecksum(std::string s)
+	int NMEA::NMEAchecksum(const char *s, int length)
 	{
 		int c = 0;
-		for (int i = 1; i < s.length() - 3; i++)
+		for (int i = 1; i < length - 3; i++)
 			c ^= s[i];
 		return c;
 	}
 
 	void NMEA::submitAIS(TAG &tag, long t, uint64_t ssc, uint16_t sl, int thisstation)
 	{
-		if (aivdm.checksum != NMEAchecksum(aivdm.sentence))
+		if (aivdm.checksum != NMEAchecksum(aivdm.sentence.str, aivdm.sentence.length))
 		{
 			if (warnings)
-				Warning() << "NMEA: incorrect checksum [" << aivdm.sentence << "] from station " << (thisstation == -1 ? station : thisstation) << ".";
+				Warning() << "NMEA: incorrect checksum [" << aivdm.sentence.toString() << "] from station " << (thisstation == -1 ? station : thisstation) << ".";
 			if (crc_check)
 				return;
 		}
 
+		if (thisstation == -1)
+			thisstation = station;
+
 		if (aivdm.count == 1)
 		{
 			msg.clear();
 			msg.Stamp(stamp ? 0 : t);
-			msg.setOrigin(aivdm.channel, thisstation == -1 ? station : thisstation, own_mmsi);
+			msg.setOrigin(aivdm.channel, thisstation, own_mmsi);
 			msg.setStartIdx(ssc);
 			msg.setEndIdx(ssc + sl);
 
-			addline(aivdm);
+			addline(aivdm.data.str, aivdm.data.length, aivdm.fillbits);
 
 			if (msg.validate())
 			{
-				if (regenerate)
+				// sentences that do not fit the message are regenerated
+				if (regenerate || !msg.NMEA.push_back(aivdm.sentence.str, aivdm.sentence.length))
 					msg.buildNMEA(tag);
-				else
-					msg.NMEA.push_back(aivdm.sentence);
 				Send(&msg, 1, tag);
 			}
 			else if (msg.getLength() > 0)
 				if (warnings)
-					Warning() << "NMEA: invalid message of type " << msg.type() << " and length " << msg.getLength() << " from station " << (thisstation == -1 ? station : thisstation) << ".";
+					Warning() << "NMEA: invalid message of type " << msg.type() << " and length " << msg.getLength() << " from station " << thisstation << ".";
 			return;
 		}
 
-		int result = search(aivdm);
+		// multiline message, continue the slot with the same sender, station, talker, channel and sequence ID
+		// if the sentence does not follow the previous one the slot is restarted or dropped
+		uint64_t now = time(nullptr);
+		Multipart *m = search(thisstation, now);
+
+		if (m && (m->count != aivdm.count || m->number + 1 != aivdm.number))
+		{
+			m->used = false;
+			m = nullptr;
+		}
 
-		if (aivdm.number != result + 1 || result == -1)
+		if (!m)
 		{
-			clean(aivdm.channel, aivdm.talkerID);
 			if (aivdm.number != 1)
-			{
 				return;
-			}
+
+			m = allocate(now);
+			m->source = source;
+			m->station = thisstation;
+			m->talkerID = aivdm.talkerID;
+			m->channel = aivdm.channel;
+			m->ID = aivdm.ID;
+			m->count = aivdm.count;
 		}
 
-		queue.push_back(aivdm);
+		m->number = aivdm.number;
+		m->fillbits = aivdm.fillbits;
+
+		int n = MIN(aivdm.data.length, Multipart::MAX_DATA - m->length);
+		std::memcpy(m->data + m->length, aivdm.data.str, n);
+		m->length += n;
+
+		if (!regenerate && m->fits)
+			m->fits = m->sentences.push_back(aivdm.sentence.str, aivdm.sentence.length);
+
 		if (aivdm.number != aivdm.count)
 			return;
 
 		// multiline messages are now complete and in the right order
-		// we create a message and add the payloads to it
+		m->used = false;
+
 		msg.clear();
 		msg.Stamp(stamp ? 0 : t);
-		msg.setOrigin(aivdm.channel, thisstation == -1 ? station : thisstation, own_mmsi);
+		msg.setOrigin(aivdm.channel, thisstation, own_mmsi);
 
-		for (auto it = queue.begin(); it != queue.end(); it++)
-		{
-			if (it->channel == aivdm.channel && it->talkerID == aivdm.talkerID && it->count == aivdm.count && it->ID == aivdm.ID)
-			{
-				addline(*it);
-				if (!regenerate)
-					msg.NMEA.push_back(it->sentence);
-			}
-		}
+		addline(m->data, m->length, m->fillbits);
 
 		if (msg.validate())
 		{
-			if (regenerate)
+			if (regenerate || !m->fits)
 				msg.buildNMEA(tag, aivdm.ID);
+			else
+				msg.NMEA = m->sentences;
 
 			Send(&msg, 1, tag);
 		}
 		else if (warnings)
 			Warning() << "NMEA: invalid message of type " << msg.type() << " and length " << msg.getLength();
-
-		clean(aivdm.channel, aivdm.talkerID);
 	}
 
-	void NMEA::addline(const AIVDM &a)
+	void NMEA::addline(const char *data, int length, int fillbits)
 	{
-		for (char d : a.data)
-			msg.appendLetter(d);
-		if (a.count == a.number)
-			msg.reduceLength(a.fillbits);
+		for (int i = 0; i < length; i++)
+			msg.appendLetter(data[i]);
+		msg.reduceLength(fillbits);
 	}
 
-	void NMEA::split(const std::string &s)
+	// fields are separated by commas, n commas give n + 1 fields
+	void NMEA::split(const char *s, int length)
 	{
-		parts.clear();
-		std::stringstream ss(s);
-		std::string p;
-		while (ss.good())
+		nparts = 0;
+
+		int start = 0;
+		for (int i = 0; i <= length; i++)
 		{
-			getline(ss, p, ',');
-			parts.push_back(p);
+			if (i == length || s[i] == ',')
+			{
+				if (nparts < MAX_PARTS)
+				{
+					parts[nparts].str = s + start;
+					parts[nparts].length = i - start;
+				}
+				nparts++;
+				start = i + 1;
+			}
 		}
 	}
 
-	std::string NMEA::trim(const std::string &s)
+	// terminated copy of a field, optionally without spaces, truncated to the buffer size
+	void NMEA::copy(const Field &f, char *buffer, int size, bool trim)
 	{
-		std::string r;
-		for (char c : s)
-			if (c != ' ')
-				r += c;
-		return r;
+		int n = 0;
+		for (int i = 0; i < f.length && n < size - 1; i++)
+			if (!trim || f[i] != ' ')
+				buffer[n++] = f[i];
+		buffer[n] = '\0';
 	}
 
 	// stackoverflow variant (need to find the reference)
@@ -220,14 +257,14 @@ namespace AIS
 
 		split(s);
 
-		if (parts.size() != 15)
+		if (nparts != 15)
 		{
-			error_msg = "NMEA: GPGGA does not have 15 parts but " + std::to_string(parts.size());
+			error_msg = "NMEA: GPGGA does not have 15 parts but " + std::to_string(nparts);
 			return false;
 		}
 
-		const std::string &crc = parts[14];
-		int checksum = crc.size() > 2 ? (fromHEX(crc[crc.length() - 2]) << 4) | fromHEX(crc[crc.length() - 1]) : -1;
+		const Field &crc = parts[14];
+		int checksum = crc.length > 2 ? (fromHEX(crc[crc.length - 2]) << 4) | fromHEX(crc[crc.length - 1]) : -1;
 
 		if (checksum != NMEAchecksum(line))
 		{
@@ -240,25 +277,27 @@ namespace AIS
 		}
 
 		// no proper fix
-		int fix = atoi(parts[6].c_str());
+		// fields are followed by a comma, atoi stops there
+		int fix = atoi(parts[6].str);
 		if (fix != 1 && fix != 2)
 		{
-			error_msg = "NMEA: no fix in GPGGA NMEA:" + parts[6];
+			error_msg = "NMEA: no fix in GPGGA NMEA:" + parts[6].toString();
 			return false;
 		}
 
-		std::string lat_coord = trim(parts[2]);
-		std::string lat_quad = trim(parts[3]);
-		std::string lon_coord = trim(parts[4]);
-		std::string lon_quad = trim(parts[5]);
+		char lat_coord[32], lat_quad[32], lon_coord[32], lon_quad[32];
+		copy(parts[2], lat_coord, sizeof(lat_coord), true);
+		copy(parts[3], lat_quad, sizeof(lat_quad), true);
+		copy(parts[4], lon_coord, sizeof(lon_coord), true);
+		copy(parts[5], lon_quad, sizeof(lon_quad), true);
 
-		if (lat_quad.empty() || lon_quad.empty())
+		if (!lat_quad[0] || !lon_quad[0])
 		{
 			return false;
 		}
 
-		GPS gps(GpsToDecimal(lat_coord.c_str(), lat_quad[0], error),
-				GpsToDecimal(lon_coord.c_str(), lon_quad[0], error),
+		GPS gps(GpsToDecimal(lat_coord, lat_quad[0], error),
+				GpsToDecimal(lon_coord, lon_quad[0], error),
 				s, empty);
 
 		if (error)
@@ -282,11 +321,11 @@ namespace AIS
 
 		split(s);
 
-		if ((parts.size() != 13 && parts.size() != 12))
+		if ((nparts != 13 && nparts != 12))
 			return false;
 
-		const std::string &crc = parts[parts.size() - 1];
-		int checksum = crc.size() > 2 ? (fromHEX(crc[crc.length() - 2]) << 4) | fromHEX(crc[crc.length() - 1]) : -1;
+		const Field &crc = parts[nparts - 1];
+		int checksum = crc.length > 2 ? (fromHEX(crc[crc.length - 2]) << 4) | fromHEX(crc[crc.length - 1]) : -1;
 
 		if (checksum != NMEAchecksum(line))
 		{
@@ -297,16 +336,20 @@ namespace AIS
 			}
 		}
 
-		std::string lat_quad = trim(parts[3]);
-		std::string lon_quad = trim(parts[5]);
-		if (lat_quad.empty() || lon_quad.empty())
+		char lat_coord[32], lat_quad[32], lon_coord[32], lon_quad[32];
+		copy(parts[3], lat_quad, sizeof(lat_quad), true);
+		copy(parts[5], lon_quad, sizeof(lon_quad), true);
+		if (!lat_quad[0] || !lon_quad[0])
 		{
 			error_msg = "NMEA: no coordinates in RMC";
 			return false;
 		}
 
-		GPS gps(GpsToDecimal(trim(parts[2]).c_str(), lat_quad[0], error),
-				GpsToDecimal(trim(parts[4]).c_str(), lon_quad[0], error), s, empty);
+		copy(parts[2], lat_coord, sizeof(lat_coord), true);
+		copy(parts[4], lon_coord, sizeof(lon_coord), true);
+
+		GPS gps(GpsToDecimal(lat_coord, lat_quad[0], error),
+				GpsToDecimal(lon_coord, lon_quad[0], error), s, empty);
 
 		if (error)
 		{
@@ -328,14 +371,14 @@ namespace AIS
 		bool error = false;
 		split(s);
 
-		if (parts.size() != 8)
+		if (nparts != 8)
 		{
-			error_msg = "NMEA: GLL does not have 8 parts but " + std::to_string(parts.size());
+			error_msg = "NMEA: GLL does not have 8 parts but " + std::to_string(nparts);
 			return false;
 		}
 
-		const std::string &crc = parts[7];
-		int checksum = crc.size() > 2 ? (fromHEX(crc[crc.length() - 2]) << 4) | fromHEX(crc[crc.length() - 1]) : -1;
+		const Field &crc = parts[7];
+		int checksum = crc.length > 2 ? (fromHEX(crc[crc.length - 2]) << 4) | fromHEX(crc[crc.length - 1]) : -1;
 
 		if (checksum != NMEAchecksum(line))
 		{
@@ -349,16 +392,20 @@ namespace AIS
 			}
 		}
 
-		std::string lat_quad = parts[2];
-		std::string lon_quad = parts[4];
+		const Field &lat_quad = parts[2];
+		const Field &lon_quad = parts[4];
 
 		if (lat_quad.empty() || lon_quad.empty())
 		{
 			return false;
 		}
 
-		float lat = GpsToDecimal(parts[1].c_str(), lat_quad[0], error);
-		float lon = GpsToDecimal(parts[3].c_str(), lon_quad[0], error);
+		char lat_coord[32], lon_coord[32];
+		copy(parts[1], lat_coord, sizeof(lat_coord), false);
+		copy(parts[3], lon_coord, sizeof(lon_coord), false);
+
+		float lat = GpsToDecimal(lat_coord, lat_quad[0], error);
+		float lon = GpsToDecimal(lon_coord, lon_quad[0], error);
 
 		if (error)
 		{
@@ -380,18 +427,20 @@ namespace AIS
 			error_msg = "NMEA: no $ or ! in AIS sentence";
 			return false;
 		}
-		std::string nmea = str.substr(pos);
 
-		bool isNMEA = nmea.size() > 10 && (nmea[3] == 'V' && nmea[4] == 'D' && (nmea[5] == 'M' || nmea[5] == 'O'));
+		// the sentence and its fields are parsed in place
+		const char *nmea = str.c_str() + pos;
+		int length = (int)str.length() - pos;
+
+		bool isNMEA = length > 10 && (nmea[3] == 'V' && nmea[4] == 'D' && (nmea[5] == 'M' || nmea[5] == 'O'));
 		if (!isNMEA)
 		{
 			return true; // no NMEA -> ignore
 		}
 
-		split(nmea);
-		aivdm.reset();
+		split(nmea, length);
 
-		if (parts.size() != 7 || parts[0].size() != 6 || parts[1].size() != 1 || parts[2].size() != 1 || parts[3].size() > 1 || parts[4].size() > 1 || parts[6].size() != 4)
+		if (nparts != 7 || parts[0].length != 6 || parts[1].length != 1 || parts[2].length != 1 || parts[3].length > 1 || parts[4].length > 1 || parts[6].length != 4)
 		{
 			error_msg = "NMEA: AIS sentence does not have 7 parts or has invalid part sizes";
 			return false;
@@ -417,18 +466,19 @@ namespace AIS
 		aivdm.talkerID = ((parts[0][1] << 8) | parts[0][2]);
 		aivdm.count = parts[1][0] - '0';
 		aivdm.number = parts[2][0] - '0';
-		aivdm.ID = parts[3].size() > 0 ? parts[3][0] - '0' : 0;
-		aivdm.channel = parts[4].size() > 0 ? parts[4][0] : '?';
+		aivdm.ID = parts[3].length > 0 ? parts[3][0] - '0' : 0;
+		aivdm.channel = parts[4].length > 0 ? parts[4][0] : '?';
 
-		for (auto c : parts[5])
+		const Field &data = parts[5];
+		for (int i = 0; i < data.length; i++)
 		{
-			if (!isNMEAchar(c))
+			if (!isNMEAchar(data[i]))
 			{
-				error_msg = "NMEA: AIS sentence contains invalid NMEA character '" + std::string(1, c) + "'";
+				error_msg = "NMEA: AIS sentence contains invalid NMEA character '" + std::string(1, data[i]) + "'";
 				return false;
 			}
 		}
-		aivdm.data = parts[5];
+		aivdm.data = data;
 		aivdm.fillbits = parts[6][0] - '0';
 
 		if (!isHEX(parts[6][2]) || !isHEX(parts[6][3]))
@@ -438,7 +488,8 @@ namespace AIS
 		}
 		aivdm.checksum = (fromHEX(parts[6][2]) << 4) | fromHEX(parts[6][3]);
 
-		aivdm.sentence = nmea;
+		aivdm.sentence.str = nmea;
+		aivdm.sentence.length = length;
 
 		submitAIS(tag, t, ssc, sl, thisstation);
 
@@ -586,6 +637,7 @@ namespace AIS
 		try
 		{
 			long t = 0;
+			source = tag.ipv4;
 
 			for (int j = 0; j < len; j++)
 			{
@@ -651,29 +703,32 @@ namespace AIS
 
 						if (((isNMEA && checksum) || newline) && line.size() > 6)
 						{
-							std::string type = line.substr(3, 3);
+							const char *type = line.c_str() + 3;
 							bool noerror = true;
-							std::string error = "unspecified error";
+							last_error = "unspecified error";
 							tag.clear();
 							t = 0;
 
-							if (type == "VDM")
-								noerror &= processAIS(line, tag, 0, 0, t, 0, error);
-							if (type == "VDO" && VDO)
-								noerror &= processAIS(line, tag, 0, 0, t, 0, error);
-							if (type == "GGA")
-								noerror &= processGGA(line, tag, t, error);
-							if (type == "RMC")
-								noerror &= processRMC(line, tag, t, error);
-							if (type == "GLL")
-								noerror &= processGLL(line, tag, t, error);
+							if (!std::strncmp(type, "VDM", 3))
+								noerror &= processAIS(line, tag, 0, 0, t, 0, last_error);
+							else if (!std::strncmp(type, "VDO", 3))
+							{
+								if (VDO)
+									noerror &= processAIS(line, tag, 0, 0, t, 0, last_error);
+							}
+							else if (!std::strncmp(type, "GGA", 3))
+								noerror &= processGGA(line, tag, t, last_error);
+							else if (!std::strncmp(type, "RMC", 3))
+								noerror &= processRMC(line, tag, t, last_error);
+							else if (!std::strncmp(type, "GLL", 3))
+								noerror &= processGLL(line, tag, t, last_error);
 
 							if (!noerror)
 							{
 								if (warnings)
 								{
 									Warning() << "NMEA: error processing NMEA line " << line;
-									Warning() << "NMEA [" << error << " (" << line << ")";
+									Warning() << "NMEA [" << last_error << " (" << line << ")";
 								}
 							}
 							reset(c);
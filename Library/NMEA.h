@@ -18,6 +18,7 @@
 #pragma once
 
 #include <iomanip>
+#include <memory>
 
 #include "Message.h"
 #include "Stream.h"
@@ -36,20 +37,28 @@ namespace AIS
 		int station = 0;
 		std::string uuid;
 
-		struct AIVDM
+		// field of the sentence being processed, points into the input line and is not terminated
+		struct Field
 		{
-			std::string sentence;
-			std::string line;
-			std::string data;
+			const char *str = nullptr;
+			int length = 0;
 
-			uint64_t timestamp;
+			bool empty() const { return length == 0; }
+			char operator[](int i) const { return str[i]; }
+			std::string toString() const { return std::string(str, length); }
+		};
+
+		static const int MAX_PARTS = 20;
+
+		Field parts[MAX_PARTS];
+		int nparts = 0;
+
+		// AIVDM/AIVDO sentence being processed, sentence and data refer to the input line
+		struct AIVDM
+		{
+			Field sentence;
+			Field data;
 
-			void reset()
-			{
-				sentence.clear();
-				data.clear();
-				timestamp = time(nullptr);
-			}
 			char channel;
 			int count;
 			int number;
@@ -59,27 +68,55 @@ namespace AIS
 			int talkerID;
 		} aivdm;
 
-		std::vector<std::string> parts;
+		// payload of a multi-sentence message collected so far, one slot per (sender, station, talker, channel, sequence ID)
+		struct Multipart
+		{
+			static const int MAX_DATA = MAX_AIS_LENGTH * 8 / 6;
+
+			bool used = false;
+			uint64_t timestamp = 0;
+
+			uint32_t source = 0;
+			int station = 0;
+			int talkerID = 0;
+			char channel = 0;
+			int ID = 0;
+			int count = 0;
+			int number = 0;
+
+			char data[MAX_DATA];
+			int length = 0;
+			int fillbits = 0;
+
+			Util::Lines sentences;
+			bool fits = true;
+		};
+
+		static const int MAX_MULTIPART = 32;
+		Multipart multipart[MAX_MULTIPART];
+
+		// sender address of the input being processed (tag.ipv4 on arrival, e.g. from Device::UDP)
+		uint32_t source = 0;
 
 		char prev = '\n';
 		int state = 0;
 		std::string line;
+		std::string last_error;
 		int count;
 		int own_mmsi = -1;
 
-		std::vector<AIVDM> queue;
-
 		void submitAIS(TAG &tag, long int t, uint64_t ssc, uint16_t sl, int thisstation);
-		void addline(const AIVDM &a);
+		void addline(const char *data, int length, int fillbits);
 		void reset(char);
-		void clean(char, int);
-		int search(const AIVDM &a);
+		Multipart *search(int station, uint64_t now);
+		Multipart *allocate(uint64_t now);
 
 		bool isNMEAchar(char c) { return (c >= 40 && c < 88) || (c >= 96 && c <= 56 + 0x3F); }
 		bool isHEX(char c) { return (c >= '0' && c <= '9') || (c >= 'A' && c <= 'F') || (c >= 'a' && c <= 'f'); }
 		int fromHEX(char c) { return (c >= '0' && c <= '9') ? (c - '0') : ((c >= 'A' && c <= 'F') ? (c - 'A' + 10) : (c - 'a' + 10)); }
 
-		int NMEAchecksum(std::string s);
+		int NMEAchecksum(const char *s, int length);
+		int NMEAchecksum(const std::string &s) { return NMEAchecksum(s.c_str(), (int)s.length()); }
 
 		float GpsToDecimal(const char *, char, bool &error);
 
@@ -93,8 +130,9 @@ namespace AIS
 
 		JSON::Parser parser;
 
-		void split(const std::string &);
-		std::string trim(const std::string &);
+		void split(const char *s, int length);
+		void split(const std::string &s) { split(s.c_str(), (int)s.length()); }
+		void copy(const Field &f, char *buffer, int size, bool trim);
 		void processJSONsentence(const std::string &s, TAG &tag, long t);
 		bool processAIS(const std::string &s, TAG &tag, long t, uint64_t ssc, uint16_t sl, int thisstation, std::string &error_msg);
 		bool processGGA(const std::string &s, TAG &tag, long t, std::string &error_msg);
@@ -132,4 +170,66 @@ namespace AIS
 
 		Connection<GPS> outGPS;
 	};
+
+	// NMEA decoding spread over worker threads, each with its own NMEA state (line assembly and multi-sentence table).
+	// Input from one source (the sender address in tag.ipv4) always goes to the same worker, so its messages stay in order.
+	class NMEAWorkers : public StreamIn<RAW>
+	{
+		struct Worker : public StreamIn<char>
+		{
+			StreamThread<char> thread;
+			NMEA nmea;
+
+			Worker(const NMEA &n) : nmea(n) { thread >> *this; }
+
+			void Receive(const char *data, int len, TAG &tag)
+			{
+				RAW r = {Format::TXT, (void *)data, len};
+				nmea.Receive(&r, 1, tag);
+			}
+		};
+
+		std::vector<std::unique_ptr<Worker>> workers;
+
+	public:
+		virtual ~NMEAWorkers() { Stop(); }
+
+		// n workers that start from a copy of the settings in nmea
+		void setup(const NMEA &nmea, int n)
+		{
+			workers.clear();
+			for (int i = 0; i < n; i++)
+				workers.push_back(std::unique_ptr<Worker>(new Worker(nmea)));
+		}
+
+		int size() const { return (int)workers.size(); }
+		NMEA &operator[](int i) { return workers[i]->nmea; }
+
+		void Start()
+		{
+			for (auto &w : workers)
+			{
+				w->thread.setQueueSize(32);
+				w->thread.Start();
+			}
+		}
+
+		void Stop()
+		{
+			for (auto &w : workers)
+				w->thread.Stop();
+		}
+
+		void Receive(const RAW *data, int len, TAG &tag)
+		{
+			if (workers.empty())
+				return;
+
+			uint32_t h = (tag.ipv4 * 2654435761u) >> 16;
+			StreamThread<char> &thread = workers[h % workers.size()]->thread;
+
+			for (int i = 0; i < len; i++)
+				thread.Receive((const char *)data[i].data, data[i].size, tag);
+		}
+	};
 }
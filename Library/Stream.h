@@ -19,6 +19,9 @@
 
 #include <vector>
 #include <iostream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 #include "Common.h"
 
@@ -102,6 +105,110 @@ public:
 	void setTag(const TAG& t) { tag = t; }
 };
 
+// Threaded edge: blocks are copied into a bounded queue and forwarded downstream
+// from a worker thread. Assumes a single upstream thread; Receive blocks when the
+// queue is full. Without Start() the edge passes data through synchronously.
+template <typename T>
+class StreamThread : public SimpleStreamInOut<T, T> {
+	struct Block {
+		std::vector<T> data;
+		int len = 0;
+		TAG tag;
+	};
+
+	std::vector<Block> queue;
+	int head = 0;
+	int count = 0;
+	int N_BLOCKS = 8;
+
+	bool running = false;
+
+	std::mutex mtx;
+	std::condition_variable cv_notempty;
+	std::condition_variable cv_notfull;
+	std::thread worker;
+
+	void Run() {
+		std::unique_lock<std::mutex> lock(mtx);
+
+		while (true) {
+			cv_notempty.wait(lock, [this] { return count > 0 || !running; });
+
+			// drain what is left before terminating
+			if (count == 0)
+				break;
+
+			Block& b = queue[head];
+			lock.unlock();
+
+			this->Send(b.data.data(), b.len, b.tag);
+
+			lock.lock();
+			head = (head + 1) % N_BLOCKS;
+			count--;
+			cv_notfull.notify_one();
+		}
+	}
+
+public:
+	virtual ~StreamThread() { Stop(); }
+
+	void setQueueSize(int n) {
+		if (!running && n > 0) N_BLOCKS = n;
+	}
+
+	void Start() {
+		std::lock_guard<std::mutex> lock(mtx);
+
+		if (running) return;
+
+		queue.resize(N_BLOCKS);
+		head = count = 0;
+		running = true;
+		worker = std::thread(&StreamThread::Run, this);
+	}
+
+	void Stop() {
+		{
+			std::lock_guard<std::mutex> lock(mtx);
+			if (!running) return;
+			running = false;
+		}
+
+		cv_notempty.notify_one();
+		cv_notfull.notify_one();
+
+		if (worker.joinable())
+			worker.join();
+	}
+
+	void Receive(const T* data, int len, TAG& tag) {
+		std::unique_lock<std::mutex> lock(mtx);
+
+		if (!running) {
+			lock.unlock();
+			this->Send(data, len, tag);
+			return;
+		}
+
+		cv_notfull.wait(lock, [this] { return count < N_BLOCKS || !running; });
+
+		if (!running) return;
+
+		// the free slot is owned by the (single) producer until count is increased
+		Block& b = queue[(head + count) % N_BLOCKS];
+		lock.unlock();
+
+		b.data.assign(data, data + len);
+		b.len = len;
+		b.tag = tag;
+
+		lock.lock();
+		count++;
+		cv_notempty.notify_one();
+	}
+};
+
 template <typename S>
 inline StreamIn<S>& operator>>(Connection<S>& a, StreamIn<S>& b) {
 	a.Connect(&b);
@@ -27,6 +27,7 @@
 #include "Utilities.h"
 #include "Message.h"
 #include "Logger.h"
+#include "SIMD.h"
 
 namespace Util
 {
@@ -609,11 +610,46 @@ namespace Util
 	}
 
 	// not using the complex class functions to be independent of internal representation
+	// the SSE2/NEON versions convert 8 samples per iteration (scaling by a power of two, so results are identical)
 	void Convert::toFloat(CU8 *in, CFLOAT32 *out, int len)
 	{
 		uint8_t *data = (uint8_t *)in;
+		int i = 0;
 
-		for (int i = 0; i < len; i++)
+#if defined(SIMD_SSE2)
+		const __m128i offset = _mm_set1_epi16(128);
+		const __m128 scale = _mm_set1_ps(1.0f / 128.0f);
+		const __m128i zero = _mm_setzero_si128();
+		float *f = (float *)out;
+
+		for (; i + 8 <= len; i += 8)
+		{
+			__m128i x = _mm_loadu_si128((const __m128i *)(data + 2 * i));
+			__m128i lo = _mm_sub_epi16(_mm_unpacklo_epi8(x, zero), offset);
+			__m128i hi = _mm_sub_epi16(_mm_unpackhi_epi8(x, zero), offset);
+
+			_mm_storeu_ps(f + 2 * i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(lo, lo), 16)), scale));
+			_mm_storeu_ps(f + 2 * i + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(lo, lo), 16)), scale));
+			_mm_storeu_ps(f + 2 * i + 8, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(hi, hi), 16)), scale));
+			_mm_storeu_ps(f + 2 * i + 12, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(hi, hi), 16)), scale));
+		}
+#elif defined(SIMD_NEON)
+		const int16x8_t offset = vdupq_n_s16(128);
+		float *f = (float *)out;
+
+		for (; i + 8 <= len; i += 8)
+		{
+			uint8x16_t x = vld1q_u8(data + 2 * i);
+			int16x8_t lo = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(x))), offset);
+			int16x8_t hi = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vget_high_u8(x))), offset);
+
+			vst1q_f32(f + 2 * i, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(lo))), 1.0f / 128.0f));
+			vst1q_f32(f + 2 * i + 4, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(lo))), 1.0f / 128.0f));
+			vst1q_f32(f + 2 * i + 8, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(hi))), 1.0f / 128.0f));
+			vst1q_f32(f + 2 * i + 12, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(hi))), 1.0f / 128.0f));
+		}
+#endif
+		for (; i < len; i++)
 		{
 			out[i].real(((int)data[2 * i] - 128) / 128.0f);
 			out[i].imag(((int)data[2 * i + 1] - 128) / 128.0f);
@@ -623,8 +659,39 @@ namespace Util
 	void Convert::toFloat(CS8 *in, CFLOAT32 *out, int len)
 	{
 		int8_t *data = (int8_t *)in;
+		int i = 0;
 
-		for (int i = 0; i < len; i++)
+#if defined(SIMD_SSE2)
+		const __m128 scale = _mm_set1_ps(1.0f / 128.0f);
+		float *f = (float *)out;
+
+		for (; i + 8 <= len; i += 8)
+		{
+			__m128i x = _mm_loadu_si128((const __m128i *)(data + 2 * i));
+			__m128i lo = _mm_srai_epi16(_mm_unpacklo_epi8(x, x), 8);
+			__m128i hi = _mm_srai_epi16(_mm_unpackhi_epi8(x, x), 8);
+
+			_mm_storeu_ps(f + 2 * i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(lo, lo), 16)), scale));
+			_mm_storeu_ps(f + 2 * i + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(lo, lo), 16)), scale));
+			_mm_storeu_ps(f + 2 * i + 8, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(hi, hi), 16)), scale));
+			_mm_storeu_ps(f + 2 * i + 12, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(hi, hi), 16)), scale));
+		}
+#elif defined(SIMD_NEON)
+		float *f = (float *)out;
+
+		for (; i + 8 <= len; i += 8)
+		{
+			int8x16_t x = vld1q_s8(data + 2 * i);
+			int16x8_t lo = vmovl_s8(vget_low_s8(x));
+			int16x8_t hi = vmovl_s8(vget_high_s8(x));
+
+			vst1q_f32(f + 2 * i, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(lo))), 1.0f / 128.0f));
+			vst1q_f32(f + 2 * i + 4, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(lo))), 1.0f / 128.0f));
+			vst1q_f32(f + 2 * i + 8, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(hi))), 1.0f / 128.0f));
+			vst1q_f32(f + 2 * i + 12, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(hi))), 1.0f / 128.0f));
+		}
+#endif
+		for (; i < len; i++)
 		{
 			out[i].real(data[2 * i] / 128.0f);
 			out[i].imag(data[2 * i + 1] / 128.0f);
@@ -634,14 +701,76 @@ namespace Util
 	void Convert::toFloat(CS16 *in, CFLOAT32 *out, int len)
 	{
 		int16_t *data = (int16_t *)in;
+		int i = 0;
 
-		for (int i = 0; i < len; i++)
+#if defined(SIMD_SSE2)
+		const __m128 scale = _mm_set1_ps(1.0f / 32768.0f);
+		float *f = (float *)out;
+
+		for (; i + 4 <= len; i += 4)
+		{
+			__m128i x = _mm_loadu_si128((const __m128i *)(data + 2 * i));
+
+			_mm_storeu_ps(f + 2 * i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16)), scale));
+			_mm_storeu_ps(f + 2 * i + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16)), scale));
+		}
+#elif defined(SIMD_NEON)
+		float *f = (float *)out;
+
+		for (; i + 4 <= len; i += 4)
+		{
+			int16x8_t x = vld1q_s16(data + 2 * i);
+
+			vst1q_f32(f + 2 * i, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(x))), 1.0f / 32768.0f));
+			vst1q_f32(f + 2 * i + 4, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(x))), 1.0f / 32768.0f));
+		}
+#endif
+		for (; i < len; i++)
 		{
 			out[i].real(data[2 * i] / 32768.0f);
 			out[i].imag(data[2 * i + 1] / 32768.0f);
 		}
 	}
 
+	// real samples at fs/4 mixed down to baseband: multiply by 1, j, -1, -j
+	void Convert::toFloatFS4(FLOAT32 *in, CFLOAT32 *out, int len)
+	{
+		int i = 0;
+
+#if defined(SIMD_SSE2)
+		const __m128 sign = _mm_castsi128_ps(_mm_set_epi32((int)0x80000000, (int)0x80000000, 0, 0));
+		const __m128 mask = _mm_castsi128_ps(_mm_set_epi32(-1, 0, 0, -1));
+		float *f = (float *)out;
+
+		for (; i + 4 <= len; i += 4)
+		{
+			// x0, x1, -x2, -x3 -> (x0, 0), (0, x1), (-x2, 0), (0, -x3)
+			__m128 x = _mm_xor_ps(_mm_loadu_ps(in + i), sign);
+
+			_mm_storeu_ps(f + 2 * i, _mm_and_ps(_mm_shuffle_ps(x, x, _MM_SHUFFLE(1, 1, 0, 0)), mask));
+			_mm_storeu_ps(f + 2 * i + 4, _mm_and_ps(_mm_shuffle_ps(x, x, _MM_SHUFFLE(3, 3, 2, 2)), mask));
+		}
+#endif
+		for (; i < len; i++)
+		{
+			switch (i & 3)
+			{
+			case 0:
+				out[i] = CFLOAT32(in[i], 0.0f);
+				break;
+			case 1:
+				out[i] = CFLOAT32(0.0f, in[i]);
+				break;
+			case 2:
+				out[i] = CFLOAT32(-in[i], 0.0f);
+				break;
+			default:
+				out[i] = CFLOAT32(0.0f, -in[i]);
+				break;
+			}
+		}
+	}
+
 	void ConvertRAW::Receive(const RAW *raw, int len, TAG &tag)
 	{
 		assert(len == 1);
@@ -673,47 +802,43 @@ namespace Util
 		switch (raw->format)
 		{
 		case Format::CU8:
-
-			size = raw->size / sizeof(CU8);
-			if (output.size() < size)
-				output.resize(size);
-			Util::Convert::toFloat((CU8 *)raw->data, output.data(), size);
+		case Format::CS8:
+			size = raw->size / 2;
 			break;
-
 		case Format::CS16:
-
-			size = raw->size / sizeof(CS16);
-			if (output.size() < size)
-				output.resize(size);
-			Util::Convert::toFloat((CS16 *)raw->data, output.data(), size);
+		case Format::F32_FS4:
+			size = raw->size / 4;
 			break;
+		default:
+			return;
+		}
 
-		case Format::CS8:
-
-			size = raw->size / sizeof(CS8);
-			if (output.size() < size)
-				output.resize(size);
-			Util::Convert::toFloat((CS8 *)raw->data, output.data(), size);
-			break;
+		// convert and send in chunks so the float samples are still in cache for the next stage
+		if (output.size() < CHUNK)
+			output.resize(CHUNK);
 
-		case Format::F32_FS4:
-			size = raw->size / sizeof(FLOAT32);
-			if (output.size() < size)
-				output.resize(size);
+		for (int i = 0; i < size; i += CHUNK)
+		{
+			int n = MIN(CHUNK, size - i);
 
-			for (int i = 0; i < size; i += 4)
+			switch (raw->format)
 			{
-				output[i] = CFLOAT32(((FLOAT32 *)raw->data)[i], 0.0f);
-				output[i + 1] = CFLOAT32(0.0f, ((FLOAT32 *)raw->data)[i + 1]);
-				output[i + 2] = CFLOAT32(-((FLOAT32 *)raw->data)[i + 2], 0.0f);
-				output[i + 3] = CFLOAT32(0.0f, -((FLOAT32 *)raw->data)[i + 3]);
+			case Format::CU8:
+				Util::Convert::toFloat((CU8 *)raw->data + i, output.data(), n);
+				break;
+			case Format::CS16:
+				Util::Convert::toFloat((CS16 *)raw->data + i, output.data(), n);
+				break;
+			case Format::CS8:
+				Util::Convert::toFloat((CS8 *)raw->data + i, output.data(), n);
+				break;
+			default:
+				Util::Convert::toFloatFS4((FLOAT32 *)raw->data + i, output.data(), n);
+				break;
 			}
-			break;
-		default:
-			return;
-		}
 
-		out.Send(output.data(), size, tag);
+			out.Send(output.data(), n, tag);
+		}
 	}
 
 	void WriteWAV::Open(const std::string &filename, int sample_rate)
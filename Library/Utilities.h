@@ -143,6 +143,7 @@ namespace Util
 		static void toFloat(CU8 *in, CFLOAT32 *out, int len);
 		static void toFloat(CS8 *in, CFLOAT32 *out, int len);
 		static void toFloat(CS16 *in, CFLOAT32 *out, int len);
+		static void toFloatFS4(FLOAT32 *in, CFLOAT32 *out, int len);
 	};
 
 	class ConvertToRAW : public SimpleStreamInOut<CFLOAT32, RAW>
@@ -229,6 +230,7 @@ namespace Util
 
 	class ConvertRAW : public SimpleStreamInOut<RAW, CFLOAT32>
 	{
+		static const int CHUNK = 16384;
 		std::vector<CFLOAT32> output;
 
 	public:
@@ -324,6 +326,105 @@ namespace Util
 		}
 	};
 
+	// NMEA line in inline storage (at most 82 characters), copying or refilling does not allocate
+	class Line
+	{
+	public:
+		static const int MAX_LENGTH = 82;
+
+	private:
+		char text[MAX_LENGTH + 1] = { 0 };
+		int len = 0;
+
+	public:
+		const char *c_str() const { return text; }
+		int length() const { return len; }
+		bool empty() const { return len == 0; }
+		char operator[](int i) const { return text[i]; }
+
+		std::string str() const { return std::string(text, len); }
+		operator std::string() const { return str(); }
+
+		void clear()
+		{
+			len = 0;
+			text[0] = '\0';
+		}
+
+		bool append(char c)
+		{
+			if (len == MAX_LENGTH)
+				return false;
+
+			text[len++] = c;
+			text[len] = '\0';
+			return true;
+		}
+
+		bool append(const char *s, int n)
+		{
+			if (len + n > MAX_LENGTH)
+				return false;
+
+			std::memcpy(text + len, s, n);
+			len += n;
+			text[len] = '\0';
+			return true;
+		}
+
+		bool assign(const std::string &s)
+		{
+			clear();
+			return append(s.c_str(), (int)s.length());
+		}
+	};
+
+	inline std::ostream &operator<<(std::ostream &os, const Line &l) { return os.write(l.c_str(), l.length()); }
+	inline std::string operator+(const Line &l, const char *s) { return l.str() + s; }
+
+	// the NMEA lines of one message, an AIS message never takes more than 5 slots
+	class Lines
+	{
+	public:
+		static const int MAX_LINES = 5;
+
+	private:
+		Line lines[MAX_LINES];
+		int count = 0;
+
+	public:
+		const Line *begin() const { return lines; }
+		const Line *end() const { return lines + count; }
+
+		int size() const { return count; }
+		bool empty() const { return count == 0; }
+		const Line &operator[](int i) const { return lines[i]; }
+
+		void clear() { count = 0; }
+
+		// next empty line, nullptr when full
+		Line *add()
+		{
+			if (count == MAX_LINES)
+				return nullptr;
+
+			lines[count].clear();
+			return &lines[count++];
+		}
+
+		// false if the line or the number of lines exceeds the capacity
+		bool push_back(const char *s, int n)
+		{
+			if (count == MAX_LINES || n > Line::MAX_LENGTH)
+				return false;
+
+			lines[count].clear();
+			return lines[count++].append(s, n);
+		}
+
+		bool push_back(const std::string &s) { return push_back(s.c_str(), (int)s.length()); }
+	};
+
 	class TemplateString
 	{
 		std::string tpl;
@@ -15,6 +15,8 @@
 	along with this program.  If not, see <https://www.gnu.org/licenses/>.
 */
 
+#include <type_traits>
+
 #include "AIS-catcher.h"
 #include "DB.h"
 
@@ -34,6 +36,7 @@ void DB::setup()
 
 	ships.resize(Nships);
 	paths.resize(Npaths);
+	msgs.resize(Nships);
 
 	first = Nships - 1;
 	last = 0;
@@ -44,8 +47,19 @@ void DB::setup()
 	{
 		ships[i].next = i - 1;
 		ships[i].prev = i + 1;
+
+		ships[i].hash_prev = HASH_FREE;
+		ships[i].hash_next = HASH_FREE;
+
+		ships[i].grid_cell = -1;
 	}
 	ships[Nships - 1].prev = -1;
+
+	hash_head.assign(Nships, HASH_END);
+
+	json_cache.resize(Nships);
+	binary_cache.resize(Nships);
+	grid_head.assign(GRID_LAT * GRID_LON, -1);
 }
 
 bool DB::isValidCoord(float lat, float lon)
@@ -75,151 +89,392 @@ void DB::getDistanceAndBearing(float lat1, float lon1, float lat2, float lon2, f
 	bearing = rad2deg(atan2(y, x));
 }
 
-void DB::getBinary(std::vector<char> &v)
-{
-	std::lock_guard<std::mutex> lock(mtx);
+static_assert(std::is_trivially_copyable<Ship>::value, "Ship is copied under the lock and should hold no heap data");
 
-	Util::Serialize::Uint64(time(nullptr), v);
-	Util::Serialize::Int32(count, v);
+// Readers copy the ships they report under the lock and serialize from that copy,
+// so that a large request only blocks Receive for the time of a memory copy.
+void DB::copyShips(std::vector<Ship> &v, std::time_t tm, bool full)
+{
+	v.reserve(count);
 
-	if (latlon_share && isValidCoord(lat, lon))
-	{
-		Util::Serialize::Int8(1, v);
-		Util::Serialize::LatLon(lat, lon, v);
-		Util::Serialize::Uint32(own_mmsi, v);
-	}
-	else
+	int ptr = first;
+	while (ptr != -1)
 	{
-		Util::Serialize::Int8(0, v);
+		const Ship &ship = ships[ptr];
+		if (ship.mmsi != 0)
+		{
+			long int delta_time = (long int)tm - (long int)ship.last_signal;
+			if (!full && delta_time > TIME_HISTORY)
+				break;
+
+			v.push_back(ship);
+		}
+		ptr = ships[ptr].next;
 	}
+}
 
-	int ptr = first;
+// Copies the ships that changed after sequence number since and collects the ships that
+// expired after it. Expiry is time based and gets its sequence number when first seen here.
+// Returns false if no delta is possible and the full list is copied instead, the same ships as copyShips
+// with full, so that a client falling back gets what a request without since returns.
+bool DB::copyDelta(std::vector<Ship> &v, std::vector<uint32_t> &expired, std::time_t tm, uint64_t since, bool full)
+{
+	bool delta = since > seq_reset && since <= seq;
 
-	delim = "";
+	int ptr = first;
 	while (ptr != -1)
 	{
-		const Ship &ship = ships[ptr];
+		Ship &ship = ships[ptr];
 		if (ship.mmsi != 0)
 		{
-			ship.Serialize(v);
+			long int delta_time = (long int)tm - (long int)ship.last_signal;
+			if (delta_time > TIME_HISTORY)
+			{
+				if (!ship.expired)
+				{
+					ship.expired = true;
+					ship.seq = ++seq;
+				}
+
+				if (delta && ship.seq > since)
+					expired.push_back(ship.mmsi);
+				else if (!delta && full)
+					v.push_back(ship);
+			}
+			else if (!delta || ship.seq > since)
+				v.push_back(ship);
 		}
 		ptr = ships[ptr].next;
 	}
+	return delta;
 }
 
-// add member to get JSON in form of array with values and keys separately
-std::string DB::getJSONcompact(bool full)
+// Copies the ships in the time window with a position inside the box, using the grid so that only
+// the cells overlapping the box are visited. The box wraps around the antimeridian if lon_min > lon_max.
+// With radius > 0 only ships within radius nmi from (lat_c, lon_c) are kept.
+void DB::copyArea(std::vector<Ship> &v, std::time_t tm, float lat_min, float lon_min, float lat_max, float lon_max, float lat_c, float lon_c, float radius)
 {
-	std::lock_guard<std::mutex> lock(mtx);
+	bool wrap = lon_min > lon_max;
 
-	const std::string null_str = "null";
-	const std::string comma = ",";
-	std::string str;
+	int lon_first = gridLon(lon_min), lon_last = gridLon(lon_max);
+	int nlon = wrap ? GRID_LON - lon_first + lon_last + 1 : lon_last - lon_first + 1;
 
-	content = "{\"count\":" + std::to_string(count) + comma;
-	if (latlon_share && isValidCoord(lat, lon))
-		content += "\"station\":{\"lat\":" + std::to_string(lat) + ",\"lon\":" + std::to_string(lon) + ",\"mmsi\":" + std::to_string(own_mmsi) + "},";
+	// a wrapping box with both ends in the same cell covers all cells, visit each once
+	nlon = MIN(nlon, GRID_LON);
 
-	content += "\"values\":[";
+	for (int y = gridLat(lat_min); y <= gridLat(lat_max); y++)
+	{
+		for (int i = 0; i < nlon; i++)
+		{
+			int ptr = grid_head[y * GRID_LON + (lon_first + i) % GRID_LON];
 
-	std::time_t tm = time(nullptr);
-	int ptr = first;
+			while (ptr != -1)
+			{
+				const Ship &ship = ships[ptr];
+				ptr = ship.grid_next;
+
+				long int delta_time = (long int)tm - (long int)ship.last_signal;
+				if (delta_time > TIME_HISTORY || !isValidCoord(ship.lat, ship.lon))
+					continue;
+
+				if (ship.lat < lat_min || ship.lat > lat_max)
+					continue;
+
+				if (wrap ? (ship.lon < lon_min && ship.lon > lon_max) : (ship.lon < lon_min || ship.lon > lon_max))
+					continue;
+
+				if (radius > 0)
+				{
+					float distance;
+					int bearing;
+
+					getDistanceAndBearing(lat_c, lon_c, ship.lat, ship.lon, distance, bearing);
+					if (distance > radius)
+						continue;
+				}
+
+				v.push_back(ship);
+			}
+		}
+	}
+}
+
+// appends the valid points of the path of ship idx, most recent first
+void DB::copyPath(int idx, std::vector<PathPoint> &v)
+{
+	uint32_t mmsi = ships[idx].mmsi;
+	int ptr = ships[idx].path_ptr;
+	int t = ships[idx].count + 1;
+
+	while (isNextPathPoint(ptr, mmsi, t))
+	{
+		if (isValidCoord(paths[ptr].lat, paths[ptr].lon))
+			v.push_back(paths[ptr]);
+
+		t = paths[ptr].count;
+		ptr = paths[ptr].next;
+	}
+}
 
-	delim = "";
+void DB::copyAllPaths(std::vector<PathPoint> &v, std::vector<uint32_t> &mmsi, std::vector<int> &start, std::time_t tm)
+{
+	int ptr = first;
 	while (ptr != -1)
 	{
 		const Ship &ship = ships[ptr];
 		if (ship.mmsi != 0)
 		{
 			long int delta_time = (long int)tm - (long int)ship.last_signal;
-			if (!full && delta_time > TIME_HISTORY)
+			if (delta_time > TIME_HISTORY)
 				break;
 
-			content += delim + "[" + std::to_string(ship.mmsi) + comma;
-			if (isValidCoord(ship.lat, ship.lon))
-			{
-				content += std::to_string(ship.lat) + comma;
-				content += std::to_string(ship.lon) + comma;
+			mmsi.push_back(ship.mmsi);
+			start.push_back(v.size());
+			copyPath(ptr, v);
+		}
+		ptr = ships[ptr].next;
+	}
+	start.push_back(v.size());
+}
 
-				if (ship.distance != DISTANCE_UNDEFINED && ship.angle != ANGLE_UNDEFINED)
-				{
-					content += std::to_string(ship.distance) + comma;
-					content += std::to_string(ship.angle) + comma;
-				}
-				else
+// distance and bearing are only in the JSON with a valid station position
+void DB::checkStation()
+{
+	if (isValidCoord(lat, lon) == json_station)
+		return;
+
+	json_station = !json_station;
+	for (Ship &ship : ships)
+		ship.json_dirty = true;
+}
+
+// Readers of the caches hold cache_mtx and take mtx only to collect the slots to report and to copy
+// the ships that changed. Receive never touches the caches, so these are rebuilt and read after mtx is released.
+void DB::getBinary(std::vector<char> &v, int64_t since)
+{
+	std::lock_guard<std::mutex> lock_cache(cache_mtx);
+
+	std::vector<Ship> list, rebuild;
+	std::vector<uint32_t> expired;
+	std::vector<int> slots, rebuild_slots;
+	std::time_t tm;
+	uint64_t s;
+	bool delta = false;
+	int n;
+	float lat, lon;
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+
+		tm = time(nullptr);
+		n = count;
+		lat = this->lat;
+		lon = this->lon;
+
+		if (since >= 0)
+			delta = copyDelta(list, expired, tm, since, true);
+		else
+		{
+			slots.reserve(count);
+
+			int ptr = first;
+			while (ptr != -1)
+			{
+				Ship &ship = ships[ptr];
+				if (ship.mmsi != 0)
 				{
-					content += null_str + comma;
-					content += null_str + comma;
+					if (ship.binary_dirty)
+					{
+						ship.binary_dirty = false;
+						rebuild.push_back(ship);
+						rebuild_slots.push_back(ptr);
+					}
+					slots.push_back(ptr);
 				}
+				ptr = ships[ptr].next;
 			}
-			else
-			{
-				content += null_str + comma;
-				content += null_str + comma;
-				content += null_str + comma;
-				content += null_str + comma;
-			}
+		}
+		s = seq;
+	}
 
-			content += (ship.level == LEVEL_UNDEFINED ? null_str : std::to_string(ship.level)) + comma;
-			content += std::to_string(ship.count) + comma;
-			content += (ship.ppm == PPM_UNDEFINED ? null_str : std::to_string(ship.ppm)) + comma;
-			content += std::string(ship.getApproximate() ? "true" : "false") + comma;
+	for (int i = 0; i < rebuild.size(); i++)
+	{
+		binary_cache[rebuild_slots[i]].clear();
+		rebuild[i].Serialize(binary_cache[rebuild_slots[i]]);
+	}
 
-			content += ((ship.heading == HEADING_UNDEFINED) ? null_str : std::to_string(ship.heading)) + comma;
-			content += ((ship.cog == COG_UNDEFINED) ? null_str : std::to_string(ship.cog)) + comma;
-			content += ((ship.speed == SPEED_UNDEFINED) ? null_str : std::to_string(ship.speed)) + comma;
+	Util::Serialize::Uint64(tm, v);
+	Util::Serialize::Int32(n, v);
 
-			content += ((ship.to_bow == DIMENSION_UNDEFINED) ? null_str : std::to_string(ship.to_bow)) + comma;
-			content += ((ship.to_stern == DIMENSION_UNDEFINED) ? null_str : std::to_string(ship.to_stern)) + comma;
-			content += ((ship.to_starboard == DIMENSION_UNDEFINED) ? null_str : std::to_string(ship.to_starboard)) + comma;
-			content += ((ship.to_port == DIMENSION_UNDEFINED) ? null_str : std::to_string(ship.to_port)) + comma;
+	if (latlon_share && isValidCoord(lat, lon))
+	{
+		Util::Serialize::Int8(1, v);
+		Util::Serialize::LatLon(lat, lon, v);
+		Util::Serialize::Uint32(own_mmsi, v);
+	}
+	else
+	{
+		Util::Serialize::Int8(0, v);
+	}
 
-			content += std::to_string(ship.last_group) + comma;
-			content += std::to_string(ship.group_mask) + comma;
+	if (since >= 0)
+	{
+		Util::Serialize::Uint64(s, v);
+		Util::Serialize::Int8(delta ? 1 : 0, v);
+		Util::Serialize::Int32(expired.size(), v);
+		for (uint32_t mmsi : expired)
+			Util::Serialize::Uint32(mmsi, v);
+	}
 
-			content += std::to_string(ship.shiptype) + comma;
-			content += std::to_string(ship.mmsi_type) + comma;
-			content += std::to_string(ship.shipclass) + comma;
+	for (const Ship &ship : list)
+		ship.Serialize(v);
 
-			content += std::to_string(ship.msg_type) + comma;
-			content += "\"" + std::string(ship.country_code) + "\",";
-			content += std::to_string(ship.status) + comma;
+	for (int ptr : slots)
+		v.insert(v.end(), binary_cache[ptr].begin(), binary_cache[ptr].end());
+}
 
-			content += ((ship.draught == DRAUGHT_UNDEFINED) ? null_str : std::to_string(ship.draught)) + comma;
-			content += ((ship.month == ETA_MONTH_UNDEFINED) ? null_str : std::to_string(ship.month)) + comma;
-			content += ((ship.day == ETA_DAY_UNDEFINED) ? null_str : std::to_string(ship.day)) + comma;
-			content += ((ship.hour == ETA_HOUR_UNDEFINED) ? null_str : std::to_string(ship.hour)) + comma;
-			content += ((ship.minute == ETA_MINUTE_UNDEFINED) ? null_str : std::to_string(ship.minute)) + comma;
+// add member to get JSON in form of array with values and keys separately
+void DB::getShipJSONcompact(const Ship &ship, std::string &content, long int delta_time)
+{
+	const std::string null_str = "null";
+	const std::string comma = ",";
+	std::string str;
 
-			content += ((ship.IMO == IMO_UNDEFINED) ? null_str : std::to_string(ship.IMO)) + comma;
+	content += "[" + std::to_string(ship.mmsi) + comma;
+	if (isValidCoord(ship.lat, ship.lon))
+	{
+		content += std::to_string(ship.lat) + comma;
+		content += std::to_string(ship.lon) + comma;
+
+		if (ship.distance != DISTANCE_UNDEFINED && ship.angle != ANGLE_UNDEFINED)
+		{
+			content += std::to_string(ship.distance) + comma;
+			content += std::to_string(ship.angle) + comma;
+		}
+		else
+		{
+			content += null_str + comma;
+			content += null_str + comma;
+		}
+	}
+	else
+	{
+		content += null_str + comma;
+		content += null_str + comma;
+		content += null_str + comma;
+		content += null_str + comma;
+	}
+
+	content += (ship.level == LEVEL_UNDEFINED ? null_str : std::to_string(ship.level)) + comma;
+	content += std::to_string(ship.count) + comma;
+	content += (ship.ppm == PPM_UNDEFINED ? null_str : std::to_string(ship.ppm)) + comma;
+	content += std::string(ship.getApproximate() ? "true" : "false") + comma;
+
+	content += ((ship.heading == HEADING_UNDEFINED) ? null_str : std::to_string(ship.heading)) + comma;
+	content += ((ship.cog == COG_UNDEFINED) ? null_str : std::to_string(ship.cog)) + comma;
+	content += ((ship.speed == SPEED_UNDEFINED) ? null_str : std::to_string(ship.speed)) + comma;
 
-			str = std::string(ship.callsign);
-			JSON::StringBuilder::stringify(str, content);
+	content += ((ship.to_bow == DIMENSION_UNDEFINED) ? null_str : std::to_string(ship.to_bow)) + comma;
+	content += ((ship.to_stern == DIMENSION_UNDEFINED) ? null_str : std::to_string(ship.to_stern)) + comma;
+	content += ((ship.to_starboard == DIMENSION_UNDEFINED) ? null_str : std::to_string(ship.to_starboard)) + comma;
+	content += ((ship.to_port == DIMENSION_UNDEFINED) ? null_str : std::to_string(ship.to_port)) + comma;
 
-			content += comma;
-			str = std::string(ship.shipname) + (ship.getVirtualAid() ? std::string(" [V]") : std::string(""));
-			JSON::StringBuilder::stringify(str, content);
+	content += std::to_string(ship.last_group) + comma;
+	content += std::to_string(ship.group_mask) + comma;
 
-			content += comma;
-			str = std::string(ship.destination);
-			JSON::StringBuilder::stringify(str, content);
+	content += std::to_string(ship.shiptype) + comma;
+	content += std::to_string(ship.mmsi_type) + comma;
+	content += std::to_string(ship.shipclass) + comma;
 
-			content += comma + std::to_string(delta_time);
-			content += comma + std::to_string(ship.flags.getPackedValue());
-			content += comma + std::to_string(ship.getValidated());
-			content += comma + std::to_string(ship.getChannels());
-			content += comma + ((ship.altitude == ALT_UNDEFINED) ? null_str : std::to_string(ship.altitude));
-			content += comma + ((ship.received_stations == RECEIVED_STATIONS_UNDEFINED) ? null_str : std::to_string(ship.received_stations)) + "]";
+	content += std::to_string(ship.msg_type) + comma;
+	content += "\"" + std::string(ship.country_code) + "\",";
+	content += std::to_string(ship.status) + comma;
 
-			delim = comma;
+	content += ((ship.draught == DRAUGHT_UNDEFINED) ? null_str : std::to_string(ship.draught)) + comma;
+	content += ((ship.month == ETA_MONTH_UNDEFINED) ? null_str : std::to_string(ship.month)) + comma;
+	content += ((ship.day == ETA_DAY_UNDEFINED) ? null_str : std::to_string(ship.day)) + comma;
+	content += ((ship.hour == ETA_HOUR_UNDEFINED) ? null_str : std::to_string(ship.hour)) + comma;
+	content += ((ship.minute == ETA_MINUTE_UNDEFINED) ? null_str : std::to_string(ship.minute)) + comma;
+
+	content += ((ship.IMO == IMO_UNDEFINED) ? null_str : std::to_string(ship.IMO)) + comma;
+
+	str = std::string(ship.callsign);
+	JSON::StringBuilder::stringify(str, content);
+
+	content += comma;
+	str = std::string(ship.shipname) + (ship.getVirtualAid() ? std::string(" [V]") : std::string(""));
+	JSON::StringBuilder::stringify(str, content);
+
+	content += comma;
+	str = std::string(ship.destination);
+	JSON::StringBuilder::stringify(str, content);
+
+	content += comma + std::to_string(delta_time);
+	content += comma + std::to_string(ship.flags.getPackedValue());
+	content += comma + std::to_string(ship.getValidated());
+	content += comma + std::to_string(ship.getChannels());
+	content += comma + ((ship.altitude == ALT_UNDEFINED) ? null_str : std::to_string(ship.altitude));
+	content += comma + ((ship.received_stations == RECEIVED_STATIONS_UNDEFINED) ? null_str : std::to_string(ship.received_stations)) + "]";
+}
+
+std::string DB::getJSONcompact(bool full, int64_t since)
+{
+	std::vector<Ship> list;
+	std::vector<uint32_t> expired;
+	std::time_t tm;
+	uint64_t s;
+	bool delta = false;
+	int n;
+	float lat, lon;
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+
+		tm = time(nullptr);
+		n = count;
+		lat = this->lat;
+		lon = this->lon;
+
+		if (since < 0)
+			copyShips(list, tm, full);
+		else
+			delta = copyDelta(list, expired, tm, since, full);
+		s = seq;
+	}
+
+	const std::string comma = ",";
+	std::string content, delim;
+
+	content = "{\"count\":" + std::to_string(n) + comma;
+	if (latlon_share && isValidCoord(lat, lon))
+		content += "\"station\":{\"lat\":" + std::to_string(lat) + ",\"lon\":" + std::to_string(lon) + ",\"mmsi\":" + std::to_string(own_mmsi) + "},";
+
+	if (since >= 0)
+	{
+		content += "\"seq\":" + std::to_string(s) + ",\"delta\":" + (delta ? "true" : "false") + ",\"expired\":[";
+		for (int i = 0; i < expired.size(); i++)
+		{
+			if (i > 0)
+				content += comma;
+			content += std::to_string(expired[i]);
 		}
-		ptr = ships[ptr].next;
+		content += "],";
+	}
+
+	content += "\"values\":[";
+
+	for (const Ship &ship : list)
+	{
+		long int delta_time = (long int)tm - (long int)ship.last_signal;
+
+		content += delim;
+		getShipJSONcompact(ship, content, delta_time);
+		delim = comma;
 	}
 	content += "],\"error\":false}\n\n";
 	return content;
 }
 
-void DB::getShipJSON(const Ship &ship, std::string &content, long int delta_time)
+// station: the station position was valid, read under the lock by the caller
+void DB::getShipJSON(const Ship &ship, std::string &content, bool station)
 {
 
 	const std::string null_str = "null";
@@ -231,7 +486,7 @@ void DB::getShipJSON(const Ship &ship, std::string &content, long int delta_time
 		content += "\"lat\":" + std::to_string(ship.lat) + ",";
 		content += "\"lon\":" + std::to_string(ship.lon) + ",";
 
-		if (isValidCoord(lat, lon))
+		if (station)
 		{
 			content += "\"distance\":" + std::to_string(ship.distance) + ",";
 			content += "\"bearing\":" + std::to_string(ship.angle) + ",";
@@ -298,39 +553,137 @@ void DB::getShipJSON(const Ship &ship, std::string &content, long int delta_time
 	JSON::StringBuilder::stringify(str, content);
 
 	content += ",\"repeat\":" + std::to_string(ship.getRepeat());
-	content += ",\"last_signal\":" + std::to_string(delta_time) + "}";
+	content += ",\"last_signal\":";
 }
 
 std::string DB::getJSON(bool full)
 {
-	std::lock_guard<std::mutex> lock(mtx);
+	std::lock_guard<std::mutex> lock_cache(cache_mtx);
+
+	std::vector<Ship> rebuild;
+	std::vector<int> slots, rebuild_slots;
+	std::vector<long int> delta_time;
+	int n;
+	float lat, lon;
+	bool station;
+	{
+		std::lock_guard<std::mutex> lock(mtx);
 
-	const std::string null_str = "null";
-	std::string str;
+		n = count;
+		lat = this->lat;
+		lon = this->lon;
+
+		checkStation();
+		station = json_station;
 
-	content = "{\"count\":" + std::to_string(count);
+		std::time_t tm = time(nullptr);
+		int ptr = first;
+
+		while (ptr != -1)
+		{
+			Ship &ship = ships[ptr];
+			if (ship.mmsi != 0)
+			{
+				long int dt = (long int)tm - (long int)ship.last_signal;
+				if (!full && dt > TIME_HISTORY)
+					break;
+
+				if (ship.json_dirty)
+				{
+					ship.json_dirty = false;
+					rebuild.push_back(ship);
+					rebuild_slots.push_back(ptr);
+				}
+				slots.push_back(ptr);
+				delta_time.push_back(dt);
+			}
+			ptr = ships[ptr].next;
+		}
+	}
+
+	for (int i = 0; i < rebuild.size(); i++)
+	{
+		json_cache[rebuild_slots[i]].clear();
+		getShipJSON(rebuild[i], json_cache[rebuild_slots[i]], station);
+	}
+
+	std::string content, delim;
+
+	content = "{\"count\":" + std::to_string(n);
 	if (latlon_share)
 		content += ",\"station\":{\"lat\":" + std::to_string(lat) + ",\"lon\":" + std::to_string(lon) + ",\"mmsi\":" + std::to_string(own_mmsi) + "}";
 	content += ",\"ships\":[";
 
-	std::time_t tm = time(nullptr);
-	int ptr = first;
+	for (int i = 0; i < slots.size(); i++)
+	{
+		content += delim;
+		content += json_cache[slots[i]];
+		content += std::to_string(delta_time[i]) + "}";
+		delim = ",";
+	}
+	content += "],\"error\":false}\n\n";
+	return content;
+}
 
-	delim = "";
-	while (ptr != -1)
+std::string DB::getJSONcompactArea(float lat_min, float lon_min, float lat_max, float lon_max)
+{
+	return getJSONcompactArea(lat_min, lon_min, lat_max, lon_max, 0, 0, -1);
+}
+
+std::string DB::getJSONcompactRadius(float lat, float lon, float radius)
+{
+	// bounding box of the circle, 1 nmi is 1/60 degree latitude
+	float dlat = radius / 60.0f;
+	float lat_min = MAX(-90.0f, lat - dlat), lat_max = MIN(90.0f, lat + dlat);
+	float lon_min = -180.0f, lon_max = 180.0f;
+
+	if (MAX(fabs(lat_min), fabs(lat_max)) < 89.0f)
 	{
-		const Ship &ship = ships[ptr];
-		if (ship.mmsi != 0)
+		float dlon = dlat / cos(deg2rad(MAX(fabs(lat_min), fabs(lat_max))));
+		if (dlon < 180.0f)
 		{
-			long int delta_time = (long int)tm - (long int)ship.last_signal;
-			if (!full && delta_time > TIME_HISTORY)
-				break;
+			lon_min = lon - dlon;
+			lon_max = lon + dlon;
 
-			content += delim;
-			getShipJSON(ship, content, delta_time);
-			delim = ",";
+			if (lon_min < -180.0f)
+				lon_min += 360.0f;
+			if (lon_max > 180.0f)
+				lon_max -= 360.0f;
 		}
-		ptr = ships[ptr].next;
+	}
+
+	return getJSONcompactArea(lat_min, lon_min, lat_max, lon_max, lat, lon, radius);
+}
+
+std::string DB::getJSONcompactArea(float lat_min, float lon_min, float lat_max, float lon_max, float lat_c, float lon_c, float radius)
+{
+	std::vector<Ship> list;
+	std::time_t tm;
+	int n;
+	float lat, lon;
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+
+		tm = time(nullptr);
+		n = count;
+		lat = this->lat;
+		lon = this->lon;
+		copyArea(list, tm, lat_min, lon_min, lat_max, lon_max, lat_c, lon_c, radius);
+	}
+
+	std::string content, delim;
+
+	content = "{\"count\":" + std::to_string(n) + ",";
+	if (latlon_share && isValidCoord(lat, lon))
+		content += "\"station\":{\"lat\":" + std::to_string(lat) + ",\"lon\":" + std::to_string(lon) + ",\"mmsi\":" + std::to_string(own_mmsi) + "},";
+
+	content += "\"values\":[";
+
+	for (const Ship &ship : list)
+	{
+		content += delim;
+		getShipJSONcompact(ship, content, (long int)tm - (long int)ship.last_signal);
+		delim = ",";
 	}
 	content += "],\"error\":false}\n\n";
 	return content;
@@ -338,205 +691,173 @@ std::string DB::getJSON(bool full)
 
 std::string DB::getShipJSON(int mmsi)
 {
+	std::lock_guard<std::mutex> lock_cache(cache_mtx);
 	std::lock_guard<std::mutex> lock(mtx);
 
 	int ptr = findShip(mmsi);
 	if (ptr == -1)
 		return "{}";
 
-	const Ship &ship = ships[ptr];
-	long int delta_time = (long int)time(nullptr) - (long int)ship.last_signal;
+	checkStation();
 
-	std::string content;
-	getShipJSON(ship, content, delta_time);
-	return content;
+	Ship &ship = ships[ptr];
+	if (ship.json_dirty)
+	{
+		ship.json_dirty = false;
+		json_cache[ptr].clear();
+		getShipJSON(ship, json_cache[ptr], json_station);
+	}
+
+	long int delta_time = (long int)time(nullptr) - (long int)ship.last_signal;
+	return json_cache[ptr] + std::to_string(delta_time) + "}";
 }
 
 std::string DB::getKML()
 {
-	std::lock_guard<std::mutex> lock(mtx);
+	std::vector<Ship> list;
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		copyShips(list, time(nullptr), false);
+	}
 
 	std::string s = "<?xml version=\"1.0\" encoding=\"UTF-8\"?><kml xmlns = \"http://www.opengis.net/kml/2.2\"><Document>";
-	int ptr = first;
-	std::time_t tm = time(nullptr);
 
-	while (ptr != -1)
-	{
-		const Ship &ship = ships[ptr];
-		if (ship.mmsi != 0)
-		{
-			long int delta_time = (long int)tm - (long int)ship.last_signal;
-			if (delta_time > TIME_HISTORY)
-				break;
-			ship.getKML(s);
-		}
-		ptr = ships[ptr].next;
-	}
+	for (const Ship &ship : list)
+		ship.getKML(s);
+
 	s += "</Document></kml>";
 	return s;
 }
 
 std::string DB::getGeoJSON()
 {
-	std::lock_guard<std::mutex> lock(mtx);
+	std::vector<Ship> list;
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		copyShips(list, time(nullptr), false);
+	}
 
 	std::string s = "{\"type\":\"FeatureCollection\",\"time_span\":" + std::to_string(TIME_HISTORY) + ",\"features\":[";
-	int ptr = first;
-	std::time_t tm = time(nullptr);
 
 	bool addcomma = false;
-	while (ptr != -1)
+	for (const Ship &ship : list)
 	{
-		const Ship &ship = ships[ptr];
-		if (ship.mmsi != 0)
-		{
-			long int delta_time = (long int)tm - (long int)ship.last_signal;
-			if (delta_time > TIME_HISTORY)
-				break;
-
-			if (addcomma)
-				s += ",";
-			addcomma = ship.getGeoJSON(s);
-		}
-		ptr = ships[ptr].next;
+		if (addcomma)
+			s += ",";
+		addcomma = ship.getGeoJSON(s);
 	}
 	s += "]}";
 	return s;
 }
 
-// needs fix, content is defined locally and in getSinglePathJSON member content is used as helper
 std::string DB::getAllPathJSON()
 {
-	std::lock_guard<std::mutex> lock(mtx);
-
-	std::string content = "{";
+	std::vector<PathPoint> points;
+	std::vector<uint32_t> mmsi;
+	std::vector<int> start;
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		copyAllPaths(points, mmsi, start, time(nullptr));
+	}
 
-	std::time_t tm = time(nullptr);
-	int ptr = first;
+	std::string content = "{", delim;
 
-	delim = "";
-	while (ptr != -1)
+	for (int i = 0; i < mmsi.size(); i++)
 	{
-		const Ship &ship = ships[ptr];
-		if (ship.mmsi != 0)
-		{
-			long int delta_time = (long int)tm - (long int)ship.last_signal;
-			if (delta_time > TIME_HISTORY)
-				break;
-
-			content += delim + "\"" + std::to_string(ship.mmsi) + "\":" + getSinglePathJSON(ptr);
-			delim = ",";
-		}
-		ptr = ships[ptr].next;
+		content += delim + "\"" + std::to_string(mmsi[i]) + "\":";
+		getSinglePathJSON(points.data() + start[i], start[i + 1] - start[i], content);
+		delim = ",";
 	}
 	content += "}\n\n";
 	return content;
 }
 
-std::string DB::getSinglePathJSON(int idx)
+void DB::getSinglePathJSON(const PathPoint *p, int n, std::string &content)
 {
-	const std::string null_str = "null";
-	std::string str;
-
-	uint32_t mmsi = ships[idx].mmsi;
-	int ptr = ships[idx].path_ptr;
-	int t = ships[idx].count + 1;
-
-	content = "[";
+	content += "[";
 
-	while (isNextPathPoint(ptr, mmsi, t))
+	for (int i = 0; i < n; i++)
 	{
-
-		if (isValidCoord(paths[ptr].lat, paths[ptr].lon))
-		{
-			content += "[";
-			content += std::to_string(paths[ptr].lat);
+		if (i > 0)
 			content += ",";
-			content += std::to_string(paths[ptr].lon);
-			content += "],";
-		}
-		t = paths[ptr].count;
-		ptr = paths[ptr].next;
+
+		content += "[";
+		content += std::to_string(p[i].lat);
+		content += ",";
+		content += std::to_string(p[i].lon);
+		content += "]";
 	}
-	if (content != "[")
-		content.pop_back();
 	content += "]";
-	return content;
 }
 
-std::string DB::getSinglePathGeoJSON(int idx)
+void DB::getSinglePathGeoJSON(uint32_t mmsi, const PathPoint *p, int n, std::string &geojson)
 {
-	uint32_t mmsi = ships[idx].mmsi;
-	int ptr = ships[idx].path_ptr;
-	int t = ships[idx].count + 1;
+	geojson += "{\"type\":\"Feature\",\"geometry\":{\"type\":\"LineString\",\"coordinates\":[";
 
-	std::string geojson = "{\"type\":\"Feature\",\"geometry\":{\"type\":\"LineString\",\"coordinates\":[";
-
-	bool hasCoordinates = false;
-	while (isNextPathPoint(ptr, mmsi, t))
+	for (int i = 0; i < n; i++)
 	{
-		if (isValidCoord(paths[ptr].lat, paths[ptr].lon))
-		{
-			if (hasCoordinates)
-				geojson += ",";
-			
-			// GeoJSON uses [longitude, latitude] format (note the order!)
-			geojson += "[";
-			geojson += std::to_string(paths[ptr].lon);
+		if (i > 0)
 			geojson += ",";
-			geojson += std::to_string(paths[ptr].lat);
-			geojson += "]";
-			hasCoordinates = true;
-		}
-		t = paths[ptr].count;
-		ptr = paths[ptr].next;
+
+		// GeoJSON uses [longitude, latitude] format (note the order!)
+		geojson += "[";
+		geojson += std::to_string(p[i].lon);
+		geojson += ",";
+		geojson += std::to_string(p[i].lat);
+		geojson += "]";
 	}
-	
+
 	geojson += "]},\"properties\":{\"mmsi\":" + std::to_string(mmsi) + "}}";
-	return geojson;
 }
 
 std::string DB::getPathJSON(uint32_t mmsi)
 {
-	std::lock_guard<std::mutex> lock(mtx);
-	int idx = findShip(mmsi);
-	if (idx == -1)
-		return "[]";
-	return getSinglePathJSON(idx);
+	std::vector<PathPoint> points;
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		int idx = findShip(mmsi);
+		if (idx == -1)
+			return "[]";
+		copyPath(idx, points);
+	}
+
+	std::string content;
+	getSinglePathJSON(points.data(), points.size(), content);
+	return content;
 }
 
 std::string DB::getPathGeoJSON(uint32_t mmsi)
 {
-	std::lock_guard<std::mutex> lock(mtx);
-	int idx = findShip(mmsi);
-	if (idx == -1)
-		return "{\"type\":\"Feature\",\"geometry\":{\"type\":\"LineString\",\"coordinates\":[]},\"properties\":{\"mmsi\":" + std::to_string(mmsi) + "}}";
-	return getSinglePathGeoJSON(idx);
+	std::vector<PathPoint> points;
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		int idx = findShip(mmsi);
+		if (idx != -1)
+			copyPath(idx, points);
+	}
+
+	std::string geojson;
+	getSinglePathGeoJSON(mmsi, points.data(), points.size(), geojson);
+	return geojson;
 }
 
 std::string DB::getAllPathGeoJSON()
 {
-	std::lock_guard<std::mutex> lock(mtx);
+	std::vector<PathPoint> points;
+	std::vector<uint32_t> mmsi;
+	std::vector<int> start;
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		copyAllPaths(points, mmsi, start, time(nullptr));
+	}
 
 	std::string content = "{\"type\":\"FeatureCollection\",\"features\":[";
 
-	std::time_t tm = time(nullptr);
-	int ptr = first;
-
-	std::string delim = "";
-	while (ptr != -1)
+	for (int i = 0; i < mmsi.size(); i++)
 	{
-		const Ship &ship = ships[ptr];
-		if (ship.mmsi != 0)
-		{
-			long int delta_time = (long int)tm - (long int)ship.last_signal;
-			if (delta_time > TIME_HISTORY)
-				break;
-
-			content += delim + getSinglePathGeoJSON(ptr);
-			delim = ",";
-		}
-		ptr = ships[ptr].next;
+		if (i > 0)
+			content += ",";
+		getSinglePathGeoJSON(mmsi[i], points.data() + start[i], start[i + 1] - start[i], content);
 	}
 	content += "]}\n\n";
 	return content;
@@ -548,30 +869,102 @@ std::string DB::getMessage(uint32_t mmsi)
 	int ptr = findShip(mmsi);
 	if (ptr == -1)
 		return "";
-	return ships[ptr].msg;
+	return msgs[ptr];
 }
 
 int DB::findShip(uint32_t mmsi)
 {
-	int ptr = first, cnt = count;
-	while (ptr != -1 && --cnt >= 0)
+	int ptr = hash_head[hash(mmsi)];
+	while (ptr != HASH_END)
 	{
 		if (ships[ptr].mmsi == mmsi)
 			return ptr;
-		ptr = ships[ptr].next;
+		ptr = ships[ptr].hash_next;
 	}
 	return -1;
 }
 
-int DB::createShip()
+int DB::createShip(uint32_t mmsi)
 {
 	int ptr = last;
+	Ship &ship = ships[ptr];
+
+	// the least recently used ship is recycled, take it out of its old bucket
+	if (ship.hash_prev != HASH_FREE)
+	{
+		if (ship.hash_next != HASH_END)
+			ships[ship.hash_next].hash_prev = ship.hash_prev;
+
+		if (ship.hash_prev != HASH_END)
+			ships[ship.hash_prev].hash_next = ship.hash_next;
+		else
+			hash_head[hash(ship.mmsi)] = ship.hash_next;
+	}
+
+	gridRemove(ptr);
+
+	// a dropped ship can no longer be reported: deltas from before its expiry, or from before now
+	// if it has not been seen to expire, are incomplete
+	if (ship.mmsi != 0)
+		seq_reset = MAX(seq_reset, ship.expired ? ship.seq - 1 : seq);
+
 	count = MIN(count + 1, Nships);
-	ships[ptr].reset();
+	ship.reset();
+	ship.mmsi = mmsi;
+	msgs[ptr].clear();
+
+	// insert at the head of the new bucket
+	int h = hash(mmsi);
+
+	ship.hash_prev = HASH_END;
+	ship.hash_next = hash_head[h];
+
+	if (hash_head[h] != HASH_END)
+		ships[hash_head[h]].hash_prev = ptr;
+
+	hash_head[h] = ptr;
 
 	return ptr;
 }
 
+void DB::gridRemove(int ptr)
+{
+	Ship &ship = ships[ptr];
+
+	if (ship.grid_cell == -1)
+		return;
+
+	if (ship.grid_next != -1)
+		ships[ship.grid_next].grid_prev = ship.grid_prev;
+
+	if (ship.grid_prev != -1)
+		ships[ship.grid_prev].grid_next = ship.grid_next;
+	else
+		grid_head[ship.grid_cell] = ship.grid_next;
+
+	ship.grid_cell = -1;
+}
+
+void DB::gridUpdate(int ptr)
+{
+	Ship &ship = ships[ptr];
+	int cell = gridLat(ship.lat) * GRID_LON + gridLon(ship.lon);
+
+	if (cell == ship.grid_cell)
+		return;
+
+	gridRemove(ptr);
+
+	ship.grid_cell = cell;
+	ship.grid_prev = -1;
+	ship.grid_next = grid_head[cell];
+
+	if (grid_head[cell] != -1)
+		ships[grid_head[cell]].grid_prev = ptr;
+
+	grid_head[cell] = ptr;
+}
+
 void DB::moveShipToFront(int ptr)
 {
 	if (ptr == first)
@@ -803,11 +1196,6 @@ bool DB::updateShip(const JSON::JSON &data, TAG &tag, Ship &ship)
 		}
 	}
 
-	if (msg_save)
-	{
-		ship.msg.clear();
-		builder.stringify(data, ship.msg);
-	}
 	return positionUpdated;
 }
 
@@ -827,25 +1215,12 @@ void DB::processBinaryMessage(const JSON::JSON &data, Ship &ship, bool &position
 	binmsg.type = type;
 
 	// Extract DAC and FI from message
-	for (const auto &p : data.getProperties())
-	{
-		if (p.Key() == AIS::KEY_DAC)
-		{
-			binmsg.dac = p.Get().getInt();
-		}
-		else if (p.Key() == AIS::KEY_FID)
-		{
-			binmsg.fi = p.Get().getInt();
-		}
-		else if (p.Key() == AIS::KEY_LAT)
-		{
-			loc_lat = p.Get().getFloat();
-		}
-		else if (p.Key() == AIS::KEY_LON)
-		{
-			loc_lon = p.Get().getFloat();
-		}
-	}
+	const JSON::Value *v;
+
+	if ((v = data.getValue(AIS::KEY_DAC)))
+		binmsg.dac = v->getInt();
+	if ((v = data.getValue(AIS::KEY_FID)))
+		binmsg.fi = v->getInt();
 
 	// if (binmsg.dac != -1 && binmsg.fi != -1)
 	if (binmsg.dac == 1 && binmsg.fi == 31)
@@ -853,6 +1228,12 @@ void DB::processBinaryMessage(const JSON::JSON &data, Ship &ship, bool &position
 		binmsg.json.clear();
 		builder.stringify(data, binmsg.json);
 		binmsg.used = true;
+
+		if ((v = data.getValue(AIS::KEY_LAT)))
+			loc_lat = v->getFloat();
+		if ((v = data.getValue(AIS::KEY_LON)))
+			loc_lon = v->getFloat();
+
 		if (isValidCoord(loc_lat, loc_lon))
 		{
 			binmsg.lat = loc_lat;
@@ -871,19 +1252,29 @@ void DB::processBinaryMessage(const JSON::JSON &data, Ship &ship, bool &position
 	}
 }
 
-std::string DB::getBinaryMessagesJSON() const
+std::string DB::getBinaryMessagesJSON()
 {
+	BinaryMessage list[MAX_BINARY_MESSAGES];
+	int startIndex;
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+
+		for (int i = 0; i < MAX_BINARY_MESSAGES; i++)
+			list[i] = binaryMessages[i];
+
+		// Start from newest message and go backward
+		startIndex = (binaryMsgIndex + MAX_BINARY_MESSAGES - 1) % MAX_BINARY_MESSAGES;
+	}
+
 	std::string result = "[";
 	bool first = true;
 
-	// Start from newest message and go backward
-	int startIndex = (binaryMsgIndex + MAX_BINARY_MESSAGES - 1) % MAX_BINARY_MESSAGES;
 	std::time_t tm = time(nullptr);
 
 	for (int i = 0; i < MAX_BINARY_MESSAGES; i++)
 	{
 		int idx = (startIndex - i + MAX_BINARY_MESSAGES) % MAX_BINARY_MESSAGES;
-		const BinaryMessage &msg = binaryMessages[idx];
+		const BinaryMessage &msg = list[idx];
 
 		if (!msg.used || (long int)tm - (long int)msg.timestamp > TIME_HISTORY)
 			continue;
@@ -923,7 +1314,7 @@ void DB::Receive(const JSON::JSON *data, int len, TAG &tag)
 	int ptr = findShip(msg->mmsi());
 
 	if (ptr == -1)
-		ptr = createShip();
+		ptr = createShip(msg->mmsi());
 
 	moveShipToFront(ptr);
 
@@ -939,12 +1330,21 @@ void DB::Receive(const JSON::JSON *data, int len, TAG &tag)
 	bool position_updated = updateShip(data[0], tag, ship);
 	position_updated &= isValidCoord(ship.lat, ship.lon);
 
+	if (msg_save)
+	{
+		msgs[ptr].clear();
+		builder.stringify(data[0], msgs[ptr]);
+	}
+
 	if (type == 1 || type == 2 || type == 3 || type == 18 || type == 19 || type == 9)
 		addToPath(ptr);
 
 	if (type == 6 || type == 8)
 		processBinaryMessage(data[0], ship, position_updated);
 
+	if (position_updated)
+		gridUpdate(ptr);
+
 	// update ship with distance and bearing if position is updated with message
 	if (position_updated && isValidCoord(lat, lon))
 	{
@@ -991,5 +1391,9 @@ void DB::Receive(const JSON::JSON *data, int len, TAG &tag)
 	else
 		tag.validated = false;
 
+	ship.seq = ++seq;
+	ship.expired = false;
+	ship.json_dirty = ship.binary_dirty = true;
+
 	Send(data, len, tag);
 }
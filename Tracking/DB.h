@@ -65,7 +65,6 @@ class DB : public StreamIn<JSON::JSON>,
 	JSON::StringBuilder builder;
 
 	int first, last, count, path_idx = 0;
-	std::string content, delim;
 	float lat = LAT_UNDEFINED, lon = LON_UNDEFINED;
 	int TIME_HISTORY = 30 * 60;
 	bool latlon_share = false;
@@ -80,13 +79,58 @@ class DB : public StreamIn<JSON::JSON>,
 	std::vector<Ship> ships;
 	std::vector<PathPoint> paths;
 
+	// last message per slot if msg_save is set, kept out of Ship so that the readers copy plain memory
+	std::vector<std::string> msgs;
+
+	// mmsi index: bucket chains through Ship::hash_prev/hash_next, maintained by createShip
+	enum
+	{
+		HASH_END = -1,
+		HASH_FREE = -2
+	};
+	std::vector<int> hash_head;
+
+	// spatial index: 1 degree cells, chained through Ship::grid_prev/grid_next, updated on position changes
+	static const int GRID_LAT = 180;
+	static const int GRID_LON = 360;
+	std::vector<int> grid_head;
+
+	static int gridLat(float lat) { return MAX(0, MIN(GRID_LAT - 1, (int)floor(lat + 90.0f))); }
+	static int gridLon(float lon) { return MAX(0, MIN(GRID_LON - 1, (int)floor(lon + 180.0f))); }
+
+	void gridRemove(int ptr);
+	void gridUpdate(int ptr);
+
+	// serialized ships per slot, rebuilt on request after a change. The JSON stops at the
+	// last_signal value, which depends on the time of the request.
+	std::vector<std::string> json_cache;
+	std::vector<std::vector<char>> binary_cache;
+	std::mutex cache_mtx;
+	bool json_station = false;
+
+	void checkStation();
+
+	// delta updates: every ship change or expiry gets the next sequence number,
+	// a client that asks for changes up to seq_reset missed a dropped ship or its expiry and gets the full list
+	uint64_t seq = 0;
+	uint64_t seq_reset = 0;
+
+	// FNV-1 hash
+	int hash(uint32_t mmsi) const
+	{
+		const uint32_t PRIME = 16777619;
+		uint32_t h = 2166136261;
+		h = (h ^ mmsi) * PRIME;
+		return h % hash_head.size();
+	}
+
 	bool isValidCoord(float lat, float lon);
 
 	static float deg2rad(float deg) { return deg * PI / 180.0f; }
 	static int rad2deg(float rad) { return (int)(360 + rad * 180 / PI) % 360; }
 
 	int findShip(uint32_t mmsi);
-	int createShip();
+	int createShip(uint32_t mmsi);
 	void moveShipToFront(int);
 	bool updateFields(const JSON::Property &p, const AIS::Message *msg, Ship &v, bool allowApproximate);
 
@@ -95,9 +139,17 @@ class DB : public StreamIn<JSON::JSON>,
 
 	static void getDistanceAndBearing(float lat1, float lon1, float lat2, float lon2, float &distance, int &bearing);
 
-	void getShipJSON(const Ship &ship, std::string &content, long int now);
-	std::string getSinglePathJSON(int);
-	std::string getSinglePathGeoJSON(int);
+	void copyShips(std::vector<Ship> &v, std::time_t tm, bool full);
+	bool copyDelta(std::vector<Ship> &v, std::vector<uint32_t> &expired, std::time_t tm, uint64_t since, bool full);
+	void copyArea(std::vector<Ship> &v, std::time_t tm, float lat_min, float lon_min, float lat_max, float lon_max, float lat_c, float lon_c, float radius);
+	std::string getJSONcompactArea(float lat_min, float lon_min, float lat_max, float lon_max, float lat_c, float lon_c, float radius);
+	void copyPath(int idx, std::vector<PathPoint> &v);
+	void copyAllPaths(std::vector<PathPoint> &v, std::vector<uint32_t> &mmsi, std::vector<int> &start, std::time_t tm);
+
+	void getShipJSON(const Ship &ship, std::string &content, bool station);
+	void getShipJSONcompact(const Ship &ship, std::string &content, long int delta_time);
+	static void getSinglePathJSON(const PathPoint *p, int n, std::string &content);
+	static void getSinglePathGeoJSON(uint32_t mmsi, const PathPoint *p, int n, std::string &geojson);
 	bool isNextPathPoint(int idx, uint32_t mmsi, int count) { return idx != -1 && paths[idx].mmsi == mmsi && paths[idx].count < count; }
 
 	AIS::Filter filter;
@@ -137,15 +189,22 @@ public:
 	{
 		if (use_GPS)
 		{
+			std::lock_guard<std::mutex> lock(mtx);
+
 			lat = data[0].getLat();
 			lon = data[0].getLon();
 		}
 	}
 
-	void getBinary(std::vector<char> &);
+	// since >= 0 requests a delta: the ships changed and the mmsi of ships expired after sequence number since.
+	// If no delta is possible all ships are returned, as without since
+	void getBinary(std::vector<char> &, int64_t since = -1);
 	std::string getShipJSON(int mmsi);
 	std::string getJSON(bool full = false);
-	std::string getJSONcompact(bool full = false);
+	std::string getJSONcompact(bool full = false, int64_t since = -1);
+	std::string getJSONcompactArea(float lat_min, float lon_min, float lat_max, float lon_max);
+	// ships within radius nmi from (lat, lon)
+	std::string getJSONcompactRadius(float lat, float lon, float radius);
 	std::string getPathJSON(uint32_t);
 	std::string getAllPathJSON();
 	std::string getPathGeoJSON(uint32_t);
@@ -161,5 +220,5 @@ public:
 	void setMsgSave(bool b) { msg_save = b; }
 	void setFilterOption(std::string &opt, std::string &arg) { filter.SetOption(opt, arg); }
 
-	std::string getBinaryMessagesJSON() const;
+	std::string getBinaryMessagesJSON();
 };
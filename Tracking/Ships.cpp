@@ -61,7 +61,9 @@ void Ship::reset() {
 	memset(country_code, 0, sizeof(country_code));
 	last_group = GROUP_OUT_UNDEFINED;
 
-	msg.clear();
+	seq = 0;
+	expired = false;
+	json_dirty = binary_dirty = true;
 }
 
 void Ship::Serialize(std::vector<char>& v) const {
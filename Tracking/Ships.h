@@ -36,6 +36,8 @@ const int ATON_MASK = 1 << 21;
 
 struct Ship {
     int prev, next;
+    int hash_prev, hash_next;
+    int grid_cell, grid_prev, grid_next;
     uint32_t mmsi;
     int count, msg_type, shipclass, mmsi_type, shiptype, heading, status, path_ptr;
     int to_port, to_bow, to_starboard, to_stern, IMO, angle, altitude, received_stations;
@@ -43,10 +45,16 @@ struct Ship {
     float lat, lon, ppm, level, speed, cog, draught, distance;
     std::time_t last_signal, last_direct_signal;
     char shipname[21], destination[21], callsign[8], country_code[3];
-    std::string msg;
     uint64_t last_group, group_mask;
     Util::PackedInt flags;
 
+    // sequence number of the last change, for delta updates
+    uint64_t seq;
+    bool expired;
+
+    // the cached JSON and binary serializations in DB need to be rebuilt
+    bool json_dirty, binary_dirty;
+
     void reset();
     int getMMSItype();
     int getShipTypeClassEri();